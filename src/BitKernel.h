@@ -0,0 +1,256 @@
+#ifndef BitKernel_h
+#define BitKernel_h
+
+#include "Life.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Words of cells, one bit per cell, with just the operations the Generations
+// kernel needs. The kernel is written once against this interface, and run on
+// whichever of these the target has: plain integers everywhere, and SSE2, AVX2
+// or NEON vectors of 64 bit words. The shifts move cells within each 64 bit
+// lane; cells carried across lanes come from a load one word along instead.
+template <class T>
+struct ScalarWord {
+  const static int lanes = 1;
+  T v;
+  static ScalarWord load(const T* p) { return { *p }; }
+  void store(T* p) const { *p = v; }
+  static ScalarWord zero() { return { 0 }; }
+  ScalarWord operator&(ScalarWord o) const { return { (T)(v & o.v) }; }
+  ScalarWord operator|(ScalarWord o) const { return { (T)(v | o.v) }; }
+  ScalarWord operator^(ScalarWord o) const { return { (T)(v ^ o.v) }; }
+  ScalarWord operator~() const { return { (T)~v }; }
+  template <int n> ScalarWord shl() const { return { (T)(v << n) }; }
+  template <int n> ScalarWord shr() const { return { (T)(v >> n) }; }
+};
+
+#if defined(__AVX2__)
+struct Avx2Word {
+  const static int lanes = 4;
+  __m256i v;
+  static Avx2Word load(const uint64_t* p) { return { _mm256_loadu_si256((const __m256i*)p) }; }
+  void store(uint64_t* p) const { _mm256_storeu_si256((__m256i*)p, v); }
+  static Avx2Word zero() { return { _mm256_setzero_si256() }; }
+  Avx2Word operator&(Avx2Word o) const { return { _mm256_and_si256(v, o.v) }; }
+  Avx2Word operator|(Avx2Word o) const { return { _mm256_or_si256(v, o.v) }; }
+  Avx2Word operator^(Avx2Word o) const { return { _mm256_xor_si256(v, o.v) }; }
+  Avx2Word operator~() const { return { _mm256_xor_si256(v, _mm256_set1_epi64x(-1)) }; }
+  template <int n> Avx2Word shl() const { return { _mm256_slli_epi64(v, n) }; }
+  template <int n> Avx2Word shr() const { return { _mm256_srli_epi64(v, n) }; }
+};
+#endif
+
+#if defined(__SSE2__)
+struct Sse2Word {
+  const static int lanes = 2;
+  __m128i v;
+  static Sse2Word load(const uint64_t* p) { return { _mm_loadu_si128((const __m128i*)p) }; }
+  void store(uint64_t* p) const { _mm_storeu_si128((__m128i*)p, v); }
+  static Sse2Word zero() { return { _mm_setzero_si128() }; }
+  Sse2Word operator&(Sse2Word o) const { return { _mm_and_si128(v, o.v) }; }
+  Sse2Word operator|(Sse2Word o) const { return { _mm_or_si128(v, o.v) }; }
+  Sse2Word operator^(Sse2Word o) const { return { _mm_xor_si128(v, o.v) }; }
+  Sse2Word operator~() const { return { _mm_xor_si128(v, _mm_set1_epi64x(-1)) }; }
+  template <int n> Sse2Word shl() const { return { _mm_slli_epi64(v, n) }; }
+  template <int n> Sse2Word shr() const { return { _mm_srli_epi64(v, n) }; }
+};
+#endif
+
+#if defined(__ARM_NEON)
+struct NeonWord {
+  const static int lanes = 2;
+  uint64x2_t v;
+  static NeonWord load(const uint64_t* p) { return { vld1q_u64(p) }; }
+  void store(uint64_t* p) const { vst1q_u64(p, v); }
+  static NeonWord zero() { return { vdupq_n_u64(0) }; }
+  NeonWord operator&(NeonWord o) const { return { vandq_u64(v, o.v) }; }
+  NeonWord operator|(NeonWord o) const { return { vorrq_u64(v, o.v) }; }
+  NeonWord operator^(NeonWord o) const { return { veorq_u64(v, o.v) }; }
+  NeonWord operator~() const { return { veorq_u64(v, vdupq_n_u64(~0ULL)) }; }
+  template <int n> NeonWord shl() const { return { vshlq_n_u64(v, n) }; }
+  template <int n> NeonWord shr() const { return { vshrq_n_u64(v, n) }; }
+};
+#endif
+
+// Steps Generations rules (B3/S23 is Generations with 2 states,
+// GenerationsTreeRule is 12345/45678/8, Generations1TreeRule is 345/2/4) a
+// word of cells at a time, with a bitwise adder network that counts live
+// neighbors, for engines that keep their cells as bit planes (bit p of each
+// cell's state in plane p).
+class GenerationsKernel {
+public:
+  // Work out whether rule is a Generations rule, and if so its birth and
+  // survival counts. Returns false if it isn't, or if it can't tell.
+  bool classify(int nStates, TreeRule* rule, CompiledRule& compiledRule) {
+    this->nStates = nStates;
+    nPlanes = 1;
+    while ((1 << nPlanes) < nStates) nPlanes++;
+    birth = survive = 0;
+    knownBirth = knownSurvive = 0;
+    if (nStates < 2 || nPlanes > maxPlanes) return false;
+    dyingState = nStates > 2 ? 2 : 0;
+    bool ok;
+    if (const CountTable* table = rule->getCountTable()) {
+      ok = classifyCounts(*table);
+    } else if (rule->getTreeRoot() >= 0) {
+      ok = classifyTree(rule, rule->getTreeRoot(), 0, 0);
+    } else {
+      ok = classifyNeighborhoods(compiledRule);
+    }
+    // The kernel assumes an empty neighborhood stays empty
+    return ok && (birth & 1) == 0;
+  }
+
+  // Count the live neighbors of a word of cells, given the rows above, of and
+  // below the cells, each also shifted to line up the neighbors to the left
+  // (xL) and right (xR). The count is returned as four bit planes (1s, 2s, 4s
+  // and 8s).
+  template <class W>
+  static inline void count(W aL, W a, W aR, W bL, W bR, W cL, W c, W cR, W& s0, W& s1, W& s2, W& s3) {
+    // Add up the three rows, then the partial sums
+    W top1 = aL ^ a ^ aR, top2 = majority(aL, a, aR);
+    W mid1 = bL ^ bR, mid2 = bL & bR;
+    W bot1 = cL ^ c ^ cR, bot2 = majority(cL, c, cR);
+    W carry1 = majority(top1, mid1, bot1);
+    W twos = top2 ^ mid2 ^ bot2, carry2 = majority(top2, mid2, bot2);
+    s0 = top1 ^ mid1 ^ bot1;
+    s1 = twos ^ carry1;
+    W carry3 = twos & carry1;
+    s2 = carry2 ^ carry3;
+    s3 = carry2 & carry3;
+  }
+
+  // New planes of a word of cells from their planes and live neighbor counts
+  template <class W>
+  inline void step(const W* planes, W s0, W s1, W s2, W s3, W* next) {
+    W occupied = planes[0];
+    W alive = planes[0];
+    for (int p = 1; p < nPlanes; p++) {
+      occupied = occupied | planes[p];
+      alive = alive & ~planes[p];
+    }
+    W dying = occupied & ~alive;
+    W stay = alive & inSet(survive, s0, s1, s2, s3);
+    W born = ~occupied & inSet(birth, s0, s1, s2, s3);
+    // Dying cells move to the next state, wrapping to 0 after the last one.
+    // Live cells that don't survive start dying (state 2), or die if there is
+    // no dying state.
+    W carry = dying;
+    W wrap = dying;
+    for (int p = 0; p < nPlanes; p++) {
+      W incremented = planes[p] ^ carry;
+      carry = carry & planes[p];
+      wrap = wrap & (((nStates >> p) & 1) ? incremented : ~incremented);
+      next[p] = incremented & dying;
+    }
+    for (int p = 0; p < nPlanes; p++) next[p] = next[p] & ~wrap;
+    next[0] = next[0] | stay | born;
+    if (nStates > 2) next[1] = next[1] | (alive & ~stay);
+  }
+
+  const static int maxPlanes = 8;
+
+private:
+  template <class W>
+  static inline W majority(W a, W b, W c) {
+    return (a & b) | (c & (a ^ b));
+  }
+
+  // Cells whose count is in the set given as a bit mask over 0..8
+  template <class W>
+  static inline W inSet(int mask, W s0, W s1, W s2, W s3) {
+    W result = W::zero();
+    for (int k = 0; k <= 8; k++) {
+      if ((mask >> k) & 1) result = result | ((k & 1 ? s0 : ~s0) & (k & 2 ? s1 : ~s1) & (k & 4 ? s2 : ~s2) & (k & 8 ? s3 : ~s3));
+    }
+    return result;
+  }
+
+  // Check one transition against a Generations rule, learning the birth and
+  // survival counts as they are seen
+  bool note(int count, int center, int result) {
+    if (center == 0) return (result == 0 || result == 1) && agree(birth, knownBirth, count, result == 1);
+    if (center == 1) return (result == 1 || result == dyingState) && agree(survive, knownSurvive, count, result == 1);
+    // Dying cells age regardless of their neighbors
+    return result == (center + 1) % nStates;
+  }
+  static bool agree(int& set, int& known, int count, bool in) {
+    int bit = 1 << count;
+    if (known & bit) return ((set & bit) != 0) == in;
+    known |= bit;
+    if (in) set |= bit;
+    return true;
+  }
+
+  bool classifyCounts(const CountTable& table) {
+    for (int s = 0; s < nStates; s++) {
+      if (table.live[s] != (s == 1)) return false;
+    }
+    for (int center = 0; center < nStates; center++) {
+      for (int k = 0; k <= 8; k++) {
+        if (!note(k, center, table.next[center][k])) return false;
+      }
+    }
+    return true;
+  }
+
+  // Walk every path through the rule tree. A Generations rule doesn't tell
+  // empty and dying neighbors apart, so they must lead to the same node, and
+  // only live neighbors (state 1) add to the count. Trees that repeat a node
+  // instead of sharing it are turned down, which is safe if slower.
+  bool classifyTree(TreeRule* rule, int node, int depth, int count) {
+    if (depth == 8) {
+      for (int center = 0; center < nStates; center++) {
+        if (!note(count, center, rule->getTreeNode(node, center))) return false;
+      }
+      return true;
+    }
+    int other = rule->getTreeNode(node, 0);
+    for (int s = 2; s < nStates; s++) {
+      if (rule->getTreeNode(node, s) != other) return false;
+    }
+    return classifyTree(rule, other, depth + 1, count) && classifyTree(rule, rule->getTreeNode(node, 1), depth + 1, count + 1);
+  }
+
+  // Rules with neither a tree nor a count table are just called, on every
+  // neighborhood. If there are too many to try them all, the rule can't be
+  // told apart from one that differs only in some untried neighborhood, so it
+  // is turned down; give it a count table or a tree to have it classified.
+  bool classifyNeighborhoods(CompiledRule& compiledRule) {
+    long all = 1;
+    for (int i = 0; i < 9 && all <= maxNeighborhoods; i++) all *= nStates;
+    if (all > maxNeighborhoods) return false;
+    int n[9];
+    for (long index = 0; index < all; index++) {
+      long i = index;
+      int count = 0;
+      for (int j = 8; j >= 0; j--) {
+        n[j] = i % nStates;
+        i /= nStates;
+        if (j < 8 && n[j] == 1) count++;
+      }
+      if (!note(count, n[8], compiledRule.transition(n))) return false;
+    }
+    return true;
+  }
+
+  const static long maxNeighborhoods = 1 << 18;
+
+  int nStates = 0;
+  int nPlanes = 0;
+  int dyingState = 0;
+  int birth = 0;
+  int survive = 0;
+  int knownBirth = 0;
+  int knownSurvive = 0;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef BitLife_h
+#define BitLife_h
+
+#include "BitKernel.h"
+#include "Life.h"
+
+// A fixed size universe (like SimpleLife) stored as bit planes: bit p of each
+// cell's state lives in plane p, and each row of a plane is packed into 64 bit
+// words, so one word holds 64 cells.
+//
+// When the rule turns out to be a Generations rule (B3/S23 is Generations with
+// 2 states, GenerationsTreeRule is 12345/45678/8, Generations1TreeRule is
+// 345/2/4), whole words are stepped at once with GenerationsKernel's bitwise
+// adder network, so no per cell rule evaluation is needed. Rows are padded
+// with empty words so that the word loop has no branches, and it runs on AVX2,
+// SSE2 or NEON vectors where the target has them (see BitKernel.h), finishing
+// each row a 64 bit word at a time. The Teensy has none of these, so it always
+// takes the 64 bit path.
+//
+// Any other rule (e.g. the colourised NiemiecTreeRule) falls back to evaluating
+// the rule for cells next to a live cell, found a word at a time.
+class BitLife : public Life {
+public:
+  BitLife(int w, int h, int nStates, TreeRule* treeRule)
+    : width(w), height(h) {
+    wordsPerRow = (w + 63) / 64;
+    lastWordMask = w % 64 ? ~0ULL >> (64 - w % 64) : ~0ULL;
+    paddedWords = wordsPerRow + 2;
+    scratch = (uint64_t*)calloc(paddedWords * (height + 2), sizeof(uint64_t));
+    setRule(nStates, treeRule);
+  }
+  ~BitLife() {
+    free(data);
+    free(next);
+    free(scratch);
+  }
+  virtual void setRule(int nStates, TreeRule* rule) {
+    treeRule = rule;
+    compiledRule.compile(nStates, rule);
+    this->nStates = nStates;
+    nPlanes = 1;
+    while ((1 << nPlanes) < nStates) nPlanes++;
+    int planeWords = wordsPerRow * height;
+    free(data);
+    free(next);
+    data = (uint64_t*)malloc(sizeof(uint64_t) * planeWords * nPlanes);
+    next = (uint64_t*)malloc(sizeof(uint64_t) * planeWords * nPlanes);
+    generations = kernel.classify(nStates, rule, compiledRule);
+    clear();
+  }
+  virtual void clear() {
+    memset(data, 0, sizeof(uint64_t) * wordsPerRow * height * nPlanes);
+  }
+  virtual size_t getStateBytes() {
+    return sizeof(uint64_t) * (2 * wordsPerRow * height * nPlanes + paddedWords * (height + 2));
+  }
+  byte get(int x, int y) {
+    if (x < 0 || x >= width) return 0;
+    if (y < 0 || y >= height) return 0;
+    int index = y * wordsPerRow + x / 64;
+    int bit = x % 64;
+    byte value = 0;
+    for (int p = 0; p < nPlanes; p++) {
+      value |= ((plane(data, p)[index] >> bit) & 1) << p;
+    }
+    return value;
+  }
+  virtual void set(int x, int y, byte value) {
+    if (x < 0 || x >= width) return;
+    if (y < 0 || y >= height) return;
+    int index = y * wordsPerRow + x / 64;
+    uint64_t bit = 1ULL << (x % 64);
+    for (int p = 0; p < nPlanes; p++) {
+      if ((value >> p) & 1) {
+        plane(data, p)[index] |= bit;
+      } else {
+        plane(data, p)[index] &= ~bit;
+      }
+    }
+  }
+  virtual void nextGeneration() {
+    if (generations) {
+      nextGenerations();
+    } else {
+      nextGeneric();
+    }
+    uint64_t* temp = data;
+    data = next;
+    next = temp;
+  }
+  virtual void iterateLiveRuns(RunVisitor& visitor) {
+    forEachLiveRun([&visitor](int x, int y, int length, const byte* values) {
+      visitor.visit(x, y, length, values);
+    });
+  }
+  // Each non-empty word is one span of 64 cells
+  template <class F>
+  void forEachLiveRun(F&& f) {
+    byte values[64];
+    for (int y = 0; y < height; y++) {
+      for (int i = 0; i < wordsPerRow; i++) {
+        int index = y * wordsPerRow + i;
+        uint64_t live = 0;
+        for (int p = 0; p < nPlanes; p++) live |= plane(data, p)[index];
+        if (!live) continue;
+        memset(values, 0, sizeof(values));
+        while (live) {
+          int bit = __builtin_ctzll(live);
+          live &= live - 1;
+          int value = 0;
+          for (int p = 0; p < nPlanes; p++) {
+            value |= ((plane(data, p)[index] >> bit) & 1) << p;
+          }
+          values[bit] = value;
+        }
+        f(i * 64, y, min(64, width - i * 64), values);
+      }
+    }
+  }
+  template <class F>
+  void forEachLive(F&& f) {
+    forEachLiveRun([&f](int x, int y, int length, const byte* values) {
+      for (int i = 0; i < length; i++) {
+        if (values[i]) f(x + i, y, values[i]);
+      }
+    });
+  }
+  // True if the current rule is stepped with the bitwise Generations kernel
+  bool isGenerations() {
+    return generations;
+  }
+
+private:
+  uint64_t* plane(uint64_t* planes, int p) {
+    return planes + p * wordsPerRow * height;
+  }
+
+  // Rows of the scratch area, which has an empty word either side of each row
+  // and an empty row above and below the universe, so that the word loops
+  // need no tests at the edges. The padding is never written.
+  uint64_t* paddedRow(int y) {
+    return scratch + (y + 1) * paddedWords + 1;
+  }
+
+  // Put the cells in state 1 in the scratch rows
+  void fillLiveRows() {
+    int n = wordsPerRow;
+    for (int y = 0; y < height; y++) {
+      uint64_t* live = paddedRow(y);
+      const uint64_t* p0 = data + y * n;
+      for (int i = 0; i < n; i++) live[i] = p0[i];
+      for (int p = 1; p < nPlanes; p++) {
+        const uint64_t* pp = plane(data, p) + y * n;
+        for (int i = 0; i < n; i++) live[i] &= ~pp[i];
+      }
+    }
+  }
+
+  void nextGenerations() {
+    fillLiveRows();
+    int n = wordsPerRow;
+    for (int y = 0; y < height; y++) {
+      // Take as much of the row as will fit in the widest vectors the target
+      // has, then the rest a word at a time
+      int i = 0;
+#if defined(__AVX2__)
+      i = stepWords<Avx2Word>(y, i);
+#endif
+#if defined(__SSE2__)
+      i = stepWords<Sse2Word>(y, i);
+#endif
+#if defined(__ARM_NEON)
+      i = stepWords<NeonWord>(y, i);
+#endif
+      stepWords<ScalarWord<uint64_t>>(y, i);
+      // Nothing is born past the right edge
+      for (int p = 0; p < nPlanes; p++) plane(next, p)[y * n + n - 1] &= lastWordMask;
+    }
+  }
+
+  // Step the words of row y from word i, W::lanes words at a time, returning
+  // where it stopped
+  template <class W>
+  int stepWords(int y, int i) {
+    int n = wordsPerRow;
+    const uint64_t* row = paddedRow(y);
+    const uint64_t* above = row - paddedWords;
+    const uint64_t* below = row + paddedWords;
+    W planes[GenerationsKernel::maxPlanes];
+    W result[GenerationsKernel::maxPlanes];
+    for (; i + W::lanes <= n; i += W::lanes) {
+      W a = W::load(above + i), b = W::load(row + i), c = W::load(below + i);
+      // Neighbor at x-1 is shifted left, x+1 shifted right, carrying across words
+      W aL = a.template shl<1>() | W::load(above + i - 1).template shr<63>();
+      W aR = a.template shr<1>() | W::load(above + i + 1).template shl<63>();
+      W bL = b.template shl<1>() | W::load(row + i - 1).template shr<63>();
+      W bR = b.template shr<1>() | W::load(row + i + 1).template shl<63>();
+      W cL = c.template shl<1>() | W::load(below + i - 1).template shr<63>();
+      W cR = c.template shr<1>() | W::load(below + i + 1).template shl<63>();
+      W s0, s1, s2, s3;
+      GenerationsKernel::count(aL, a, aR, bL, bR, cL, c, cR, s0, s1, s2, s3);
+      int index = y * n + i;
+      for (int p = 0; p < nPlanes; p++) planes[p] = W::load(plane(data, p) + index);
+      kernel.step(planes, s0, s1, s2, s3, result);
+      for (int p = 0; p < nPlanes; p++) result[p].store(plane(next, p) + index);
+    }
+    return i;
+  }
+
+  void nextGeneric() {
+    int n = wordsPerRow;
+    int planeWords = n * height;
+    memset(next, 0, sizeof(uint64_t) * planeWords * nPlanes);
+    for (int y = 0; y < height; y++) {
+      uint64_t* occupied = paddedRow(y);
+      for (int i = 0; i < n; i++) occupied[i] = data[y * n + i];
+      for (int p = 1; p < nPlanes; p++) {
+        const uint64_t* pp = plane(data, p) + y * n;
+        for (int i = 0; i < n; i++) occupied[i] |= pp[i];
+      }
+    }
+    for (int y = 0; y < height; y++) {
+      const uint64_t* row = paddedRow(y);
+      for (int i = 0; i < n; i++) {
+        // Cells with anything in their neighborhood
+        uint64_t column = row[i - paddedWords] | row[i] | row[i + paddedWords];
+        uint64_t prev = row[i - paddedWords - 1] | row[i - 1] | row[i + paddedWords - 1];
+        uint64_t after = row[i - paddedWords + 1] | row[i + 1] | row[i + paddedWords + 1];
+        uint64_t active = column | (column << 1) | (prev >> 63) | (column >> 1) | (after << 63);
+        if (i == n - 1) active &= lastWordMask;
+        while (active) {
+          int bit = __builtin_ctzll(active);
+          active &= active - 1;
+          int x = i * 64 + bit;
+          int neighbors[] = {
+            get(x - 1, y - 1), get(x, y - 1), get(x + 1, y - 1),
+            get(x - 1, y), get(x + 1, y),
+            get(x - 1, y + 1), get(x, y + 1), get(x + 1, y + 1),
+            get(x, y)
+          };
+          int value = compiledRule.transition(neighbors);
+          uint64_t mask = 1ULL << bit;
+          for (int p = 0; p < nPlanes; p++) {
+            if ((value >> p) & 1) plane(next, p)[y * n + i] |= mask;
+          }
+        }
+      }
+    }
+  }
+
+  int width;
+  int height;
+  int wordsPerRow;
+  int paddedWords;
+  uint64_t lastWordMask;
+  int nStates;
+  int nPlanes;
+  bool generations;
+  GenerationsKernel kernel;
+  uint64_t* data = 0;
+  uint64_t* next = 0;
+  uint64_t* scratch;
+  TreeRule* treeRule;
+  CompiledRule compiledRule;
+};
+#endif
@@ -1,6 +1,6 @@
 #ifndef char_stream_h
 #define char_stream_h
-#include <Arduino.h>
+#include "Platform.h"
 
 class CharStream : public Stream {
    public:
@@ -30,7 +30,7 @@ class CharStream : public Stream {
         }
         return pEnd - p;
     }
-    virtual size_t write(uint8_t c) {
+    virtual size_t write(uint8_t /*c*/) {
         return 0;
     }
 
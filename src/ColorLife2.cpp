@@ -6,7 +6,9 @@
 #include <SmartMatrix.h>
 
 #include "LEDMatrixLife.h"
-#include "CharStream.h"
+#include "PatternCatalog.h"
+#include "Random.h"
+#include "SoupScout.h"
 
 #define COLOR_DEPTH 24                                         // Choose the color depth used for storing pixels in the layers: 24 or 48 (24 is good for most sketches - If the sketch uses type `rgb24` directly, COLOR_DEPTH must be 24)
 const uint16_t kMatrixWidth = 64;                              // Set to the width of your display, must be a multiple of 8
@@ -76,7 +78,18 @@ const rgb24 defaultColors[nDefaultColors] = { dead, red, orange, yellow, green,
 const int xSize = kMatrixWidth;
 const int ySize = kMatrixHeight;
 LEDMatrixLife* life;
+// Ints of cell data each InfiniteLife generation may take, past which it culls
+const int lifeDataCap = 32768;
+const int scoutDataCap = 8192;
 NiemiecTreeRule defaultRule;
+// Everything start() picks comes from rng, and the rule is deterministic, so a
+// run can be shown again by setting rng back to the state it started from
+LifeRandom rng;
+// Tries soups in the time between frames, so startRandom can show good ones
+SoupScout* scout;
+// Set by "S<seed>" to show that soup next
+bool soupRequested = false;
+uint64_t requestedSoup;
 
 // Teensy 3.0 has the LED on pin 13
 const int ledPin = 13;
@@ -87,6 +100,8 @@ time_t getTeensy3Time() {
 
 /*  code to process time sync messages from the serial port   */
 #define TIME_HEADER "T"  // Header tag for serial time sync message
+#define REPLAY_HEADER 'R'  // "R<state>" shows the run printed as "Start <state>" again, except a scouted soup
+#define SOUP_HEADER 'S'    // "S<seed>" shows the soup printed as "Soup <seed>" again
 
 unsigned long processSyncMessage() {
   unsigned long pctime = 0L;
@@ -161,7 +176,7 @@ void setup() {
   }
 
   Entropy.Initialize();
-  randomSeed(Entropy.random());
+  rng.randomSeed((uint64_t)Entropy.random() << 32 | Entropy.random());
 
   matrix.addLayer(&backgroundLayer);
   matrix.begin();
@@ -169,35 +184,60 @@ void setup() {
   backgroundLayer.enableColorCorrection(true);
 
   //life = new SimpleLife(xSize, ySize, new NiemiecTreeRule());
-  Life* lifeImplementation = new InfiniteLife(9, &defaultRule);
+  Life* lifeImplementation = new InfiniteLife(9, &defaultRule, 10000, lifeDataCap);
   //Life* lifeImplementation = new SimpleLife(xSize, ySize, defaultRule);
   life = new LEDMatrixLife(*lifeImplementation, &backgroundLayer);
+
+  // The scout only needs to score lifespan, population and motion, so it gets
+  // a much smaller cap, leaving the memory for the engine on the matrix. Soups
+  // big enough to reach it are culled sooner than they will be when shown.
+  scout = new SoupScout(*new InfiniteLife(9, &defaultRule, 2000, scoutDataCap), xSize, ySize, nDefaultColors);
+  scout->randomSeed((uint64_t)Entropy.random() << 32 | Entropy.random());
+  life->setIdleTask([](unsigned long deadline) {
+    scout->work(deadline);
+  });
 }
 
 void start(LEDMatrixLife* life);
-void SteepleChase(LEDMatrixLife* life);
-void Lava(LEDMatrixLife* life);
-void tannersp46gun(LEDMatrixLife* life);
-void snarkcatalystvariants(LEDMatrixLife* life);
-void ASJ2023(LEDMatrixLife* life);
+void startGreeting(LEDMatrixLife* life);
+void startPattern(LEDMatrixLife* life);
+void startDate(LEDMatrixLife* life);
 void startText(LEDMatrixLife* life, const char* text);
 void startRandom(LEDMatrixLife* life);
-void rpentomino(LEDMatrixLife* life);
-void p107penominohassler(LEDMatrixLife* life);
-void lobstr(LEDMatrixLife* life);
-void period201glidergun(LEDMatrixLife* life);
-void SirRobin(LEDMatrixLife* life);
-void loadrle(LEDMatrixLife* life, int x, int y, const char *rle);
+void startSoup(LEDMatrixLife* life, uint64_t seed);
+
+// What start() shows, each with its chance in 100. startPattern then picks a
+// pattern from the catalog by the patterns' own weights.
+struct StartChoice {
+  int weight;
+  void (*start)(LEDMatrixLife* life);
+};
+const StartChoice startChoices[] = {
+  { 10, startGreeting },
+  { 9, startPattern },
+  { 8, startDate },
+  { 73, startRandom },
+};
+const int nStartChoices = sizeof(startChoices) / sizeof(startChoices[0]);
 
 // the loop() method runs over and over again,
 // as long as the board has power
 void loop() {
   if (Serial.available()) {
-    time_t t = processSyncMessage();
-    if (t != 0) {
-      Serial.println("Clock set from pctime");
-      Teensy3Clock.set(t);  // set the RTC
-      setTime(t);
+    if (Serial.peek() == REPLAY_HEADER) {
+      Serial.read();
+      rng.setState(strtoull(Serial.readStringUntil('\n').c_str(), 0, 16));
+    } else if (Serial.peek() == SOUP_HEADER) {
+      Serial.read();
+      requestedSoup = strtoull(Serial.readStringUntil('\n').c_str(), 0, 16);
+      soupRequested = true;
+    } else {
+      time_t t = processSyncMessage();
+      if (t != 0) {
+        Serial.println("Clock set from pctime");
+        Teensy3Clock.set(t);  // set the RTC
+        setTime(t);
+      }
     }
   }
 
@@ -208,44 +248,72 @@ void loop() {
   start(life);
 }
 
+void printState(const char* label, uint64_t state) {
+  Serial.printf("%s %08lx%08lx\n", label, (unsigned long)(state >> 32), (unsigned long)(state & 0xffffffff));
+}
+
 void start(LEDMatrixLife* life) {
+  printState("Start", rng.getState());
   life->clear();
   life->setRule(9, &defaultRule);
   life->setColorMap(nDefaultColors, defaultColors);
   life->setInitialDelay(0);
   life->setViewportSpeed(0, 0, 0);
-  // SirRobin(life);
-  //startText(life, "JAJ\n60 years\n2024");
-  int r = random(100);
-  if (r < 10) {
-    //ASJ2023(life);
-    startText(life, "JAJ\n60 years\n2024");
-  } else if (r == 10) {
-    snarkcatalystvariants(life);
-  } else if (r == 11) {
-    tannersp46gun(life);
-  } else if (r == 12) {
-    SteepleChase(life);
-  } else if (r == 13) {
-    Lava(life);
-  } else if (r == 14) {
-    rpentomino(life);
-  } else if (r == 15) {
-    p107penominohassler(life);
-  } else if (r == 16) {
-    lobstr(life);
-  } else if (r == 17) {
-    period201glidergun(life);
-  } else if (r == 18) {
-    SirRobin(life);    
-  } else if (r < 27 && year()>=2023) {
-    char buffer[40];
-    const char* months[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
-    sprintf(buffer, "%s %d\n%d\n%02d:%02d:%02d", months[month() - 1], day(), year(), hour(), minute(), second());
-    startText(life, buffer);
-  } else {
+  if (soupRequested) {
+    soupRequested = false;
+    startSoup(life, requestedSoup);
+    return;
+  }
+  int r = rng.random(100);
+  for (int i = 0; i < nStartChoices; i++) {
+    r -= startChoices[i].weight;
+    if (r < 0 || i == nStartChoices - 1) {
+      startChoices[i].start(life);
+      return;
+    }
+  }
+}
+
+void startGreeting(LEDMatrixLife* life) {
+  startText(life, "JAJ\n60 years\n2024");
+}
+
+void startPattern(LEDMatrixLife* life) {
+  const PackedPattern* pattern = pickPattern(patternCatalog, nCatalogPatterns, rng);
+  if (!pattern) {
     startRandom(life);
+    return;
+  }
+  const PatternDisplay& display = pattern->display;
+  int nStates;
+  TreeRule* rule = patternTreeRule(pattern->rule, nStates);
+  life->setRule(nStates, rule);
+  if (display.palette) {
+    static rgb24 colors[16];
+    int nColors = min(display.nColors, 16);
+    for (int i = 0; i < nColors; i++) {
+      uint32_t c = display.palette[i];
+      colors[i] = rgb24(c >> 16, (c >> 8) & 0xff, c & 0xff);
+    }
+    life->setColorMap(nColors, colors);
   }
+  int x = display.left >= 0 ? display.left : (xSize - pattern->width) / 2;
+  int y = display.top >= 0 ? display.top : (ySize - pattern->height) / 2;
+  loadPackedPattern(life->getLife(), x, y, *pattern, rng);
+  life->setViewportSpeed(display.speedX, display.speedY, display.speedDivisor);
+  life->setInitialDelay(display.initialDelay);
+  life->run();
+}
+
+void startDate(LEDMatrixLife* life) {
+  if (year() < 2023) {
+    startRandom(life);
+    return;
+  }
+  char buffer[40];
+  const char* months[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  sprintf(buffer, "%s %d\n%d\n%02d:%02d:%02d", months[month() - 1], day(), year(), hour(), minute(), second());
+  startText(life, buffer);
 }
 
 void startText(LEDMatrixLife* life, const char* text) {
@@ -290,244 +358,20 @@ void startText(LEDMatrixLife* life, const char* text) {
   life->run();
 }
 
+// The best soup the scout has found since the last one, or any soup if it
+// hasn't found one yet. rng moves on either way, so that the choices after
+// this don't depend on what the scout had queued. Scouted soups depend on how
+// much time the scout had, so "R<state>" can't show them again, only the
+// "S<seed>" printed for them.
 void startRandom(LEDMatrixLife* life) {
-  float prob = .25;
-  for (int y = 0; y < ySize; y++) {
-    for (int x = 0; x < xSize; x++) {
-      int r = random(256);
-      int on = r / 256. < prob ? 1 + (r % (nDefaultColors - 1)) : 0;
-      life->set(x, y, on);
-    }
-  }
-  life->run();
-}
-
-// Lava rule by Mirek Wojtowicz
-void Lava(LEDMatrixLife* life) {
-  int x = 63, y = 63;  // rule = 12345/45678/8:T300,300
-  GenerationsTreeRule rule;
-  life->setRule(8, &rule);
-  const int nColors = 8;
-  const rgb24 colors[nColors] = { dead, rgb24(255, 0, 0), rgb24(255, 42, 0), rgb24(255, 84, 0), rgb24(255, 126, 0), rgb24(255, 168, 0), rgb24(255, 210, 0), rgb24(255, 254, 0) };
-  life->setColorMap(nColors, colors);
-  const char* rle = R"(
-    63A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$
-    A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A
-    $A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.
-    A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A
-    61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$
-    A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A
-    $A61.A$A61.A$A61.A$63A!
-  )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->run();
+  uint64_t seed = rng.next();
+  scout->take(seed);
+  startSoup(life, seed);
 }
 
-// Star Wars Fun collection
-// 
-// Steeplechase, p20
-// 
-// Mirek Wojtowicz, May 1999
-void SteepleChase(LEDMatrixLife* life) {
-  int x = 63, y = 59;  // rule = 345/2/4:P500,500
-  Generations1TreeRule rule;
-  life->setRule(4, &rule);
-  const rgb24 colors[4] = { dead, rgb24(255, 0, 0), rgb24(255, 128, 0),  rgb24(255, 255, 0) };
-  life->setColorMap(4, colors);
-
-  const char* rle = R"(
-    2$31.A$30.3A8.A2.A$31.A8.6A$31.A9.A2.A$30.3A8.A2.A$31.A8.6A$31.A9.A2.
-    A$30.3A8.A2.A$31.A8.6A$5.CB24.A9.A2.A$7.C22.3A8.A2.A$4.A.A.B22.A8.6A
-    10.CB$.A.6A22.A9.A2.A11.A.A$.B2A2.A.A11.A9.3A8.A2.A10.3A$.C.BA.CB11.
-    3A9.A8.6A10.A$20.A10.A9.A2.A$20.A9.3A$19.3A9.A$20.A10.A$20.A9.3A$19.
-    3A9.A$20.A10.A$20.A9.3A$19.3A9.A$20.A4$61.A$60.3A$48.A12.A$16.A4.A15.
-    A9.3A11.A$2.A12.3A2.3A13.3A7.2A.2A10.2A$.3A12.A.2A.A13.2A.2A5.2A.A.2A
-    9.A$2.A13.A.2A.A12.2A.A.2A5.2A.A.2A8.A$.ABC11.3A2.3A10.2A.A.2A7.2A.2A
-    9.2A$16.A4.A12.2A.2A9.3A10.A$35.3A11.A11.A$36.A23.3A$61.A10$14.A4.A4.
-    A8.A6.A9.A$13.3A2.3A2.3A6.3A4.3A7.3A$14.A.2A.A.2A.A8.A6.A9.A6.A.C$3.A
-    10.A.2A.A.2A.A8.A6.A9.A5.3AB$2.3A8.3A2.3A2.3A6.3A4.3A7.3A5.A.A$3.A10.
-    A4.A4.A8.A6.A9.A$2.ABC!
-  )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
+void startSoup(LEDMatrixLife* life, uint64_t seed) {
+  printState("Soup", seed);
+  LifeRandom soupRng(seed);
+  fillSoup(life->getLife(), soupRng, xSize, ySize, .25, nDefaultColors);
   life->run();
 }
-
-//#N p107rpentominohassler.rle
-//#O Mitchell Riley, 2023
-//#C https://conwaylife.com/wiki/86P107
-//#C https://www.conwaylife.com/patterns/p107rpentominohassler.rle
-void p107penominohassler(LEDMatrixLife* life) {
-  int x = 51, y = 30; // rule = B3/S23
-  const char* rle = R"(
-    6bo$6b3o$9bo$8b2o32b2o$42b2o2$b2o29b2o$bo30bo16b2o$2b3o25bobo16bo$4bo
-    25b2o15bobo$47b2o$10b2o$2o7bo2bo$2o6b2ob2o$10bo$40bo$38b2ob2o6b2o$38b
-    o2bo7b2o$39b2o$2b2o$bobo15b2o25bo$bo16bobo25b3o$2o16bo30bo$17b2o29b2o
-    2$7b2o$7b2o32b2o$41bo$42b3o$44bo!
-  )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->run();
-}
-
-void ASJ2023(LEDMatrixLife* life) {
-  life->setInitialDelay(1000);
-  int x = 30, y = 22;
-  const char* rle = R"(
-    6.2B5.4C5.5A$5.B2.B3.C4.C6.A$4.B4.B2.C11.A$4.B4.B2.C11.A$4.B4.B3.4C7.
-    A$4.6B7.C6.A$4.B4.B7.C6.A$4.B4.B2.C4.C2.A3.A$4.B4.B3.4C4.3A5$.4D5.2E5.
-    4F3.6G$D4.D3.E2.E3.F4.F7.G$D4.D2.E4.E2.F4.F6.G$5.D2.E4.E7.F5.G$4.D3.E
-    4.E6.F5.3G$2.2D4.E4.E4.2F9.G$.D6.E4.E3.F11.G$D8.E2.E3.F7.G4.G$6D4.2E4.
-    6F3.4G!
-    )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->setInitialDelay(1000);
-  life->run();
-}
-
-void snarkcatalystvariants(LEDMatrixLife* life) {
-  //#N snarkcatalystvariants.rle
-  //#C four Snark catalyst variants
-  //#C    Top:  original variant by Mike Playle
-  //#C   Left:  Shannon Omick (better clearance on a diagonal)
-  //#C  Right:  Heinrich Koenig (better clearance on a different diagonal)
-  //#C Bottom:  Simon Ekstrom (better clearance on two diagonals)
-  //#C https://conwaylife.com/wiki/Snark
-  //#C https://www.conwaylife.com/patterns/snarkcatalystvariants.rle
-  int x = 51, y = 52;
-  const char* rle = R"(
-    20.2A$20.A.A$22.A4.2A$18.4A.2A2.A2.A$18.A2.A.A.A.A.2A$21.A.A.A.A$22.2A
-    .A.A$26.A2$12.2A$13.A7.2A$13.A.A5.2A$14.2A25.B$39.3B$38.B$38.2B3$46.2B
-    $24.2A21.B$24.A22.B.2B$14.3E8.3A11.2B4.3B2.B$4.D11.E10.A11.2B3.B3.2B$
-    2.5D8.E5.2D21.4B$.D5.D13.D8.2B15.B$.D2.3D12.D.D7.B.B12.3B$2D.D15.2D8.
-    B13.B$D2.4D21.2B14.5B$.2D3.D3.2D11.C22.B2.B$3.3D4.2D11.3C22.2B$3.D22.
-    C$2D.D21.2C$2D.2D3$11.2D$12.D$9.3D$9.D25.2C$28.2C5.C.C$28.2C7.C$37.2C
-    2$24.C$23.C.C.2C4.2C$23.C.C.C.C2.C2.C$22.2C.C.C.C3.2C$23.C2.2C.4C$23.
-    C4.C3.C$24.3C.C2.C$26.C.C.C$29.C!
-    )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->run();
-}
-
-void tannersp46gun(LEDMatrixLife* life) {
-  //#N tannersp46gun.rle
-  //#C https://conwaylife.com/wiki/Tanner%27s_p46
-  //#C https://www.conwaylife.com/patterns/tannersp46gun.rle
-  //int x = 31, y = 44;
-  const char* rle = R"(
-    17.2B5.2C$17.2B5.2C11$17.B7.C$15.B.2B5.2C.C$15.B3.2B.2C3.C$16.B3.B.C3.
-    C$17.3B3.3C10$14.A14.A$13.3A14.A$12.A.A.A11.3A$12.A.A.A$10.2A.3A.2A$9.
-    A.2A.A.2A.A$3.2D3.2A.A5.A.2A$3.2D4.2A.A3.A.2A2.A.2A$10.3A3.3A3.2A.A2$
-    2.2D$3.D$3D$D13.D$13.D.D.D.2D$12.D.2D.2D.D$12.D$11.2D!
-    )";
-  loadrle(life, 0, 0, rle);
-  life->run();
-}
-
-void rpentomino(LEDMatrixLife* life) {
-  //#N R-pentomino
-  //#C A methuselah with lifespan 1103.
-  //#C www.conwaylife.com/wiki/index.php?title=R-pentomino
-  int x = 3, y = 3;// rule = B3/S23
-  const char* rle = "b2o$2ob$bo!";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->run();
-}
-
-void lobstr(LEDMatrixLife* life) {
-  //#N lobster.rle
-  //#O Matthias Merzenich, 2011
-  //#C https://conwaylife.com/wiki/Lobster_(spaceship)
-  //#C https://www.conwaylife.com/patterns/lobster.rle
-  int x = 26, y = 26;
-  const char* rle = R"(
-    12b3o$12bo$13bo2b2o$16b2o$12b2o$13b2o$12bo2bo2$14bo2bo$14bo3bo$15b3obo
-    $20bo$2o2bobo13bo$obob2o13bo$o4bo2b2o13b2o$6bo3bo6b2o2b2o2bo$2b2o6bo6b
-    o2bo$2b2o4bobo4b2o$9bo5bo3bo3bo$10bo2bo4b2o$11b2o3bo5bobo$15bo8b2o$15b
-    o4bo$14bo3bo$14bo5b2o$15bo5bo!
-    )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->setViewportSpeed(-10, -10, 70);
-  life->run();
-}
-
-void period201glidergun(LEDMatrixLife* life) {
-  //#N period201glidergun.rle
-  //#O iNoMed, 2023
-  //#C https://conwaylife.com/wiki/Period-201_glider_gun
-  //#C https://www.conwaylife.com/patterns/period201glidergun.rle
-  int x = 60, y = 32; // rule = B3/S23
-  const char* rle = R"(
-    17bo6b2o$17b3o4b2o28b2o$20bo33b2o$11bo7b2o16b3o$11b3o21bob3o$14bo19bo$
-    13b2o18b2o$34b2o$35bo$2o$bo$bobo$2b2o7$56b2o$56bobo$58bo$58b2o$24bo$
-    24b2o$25b2o18b2o$25bo19bo$20b3obo21b3o$20b3o16b2o7bo$4b2o33bo$4b2o28b
-    2o4b3o$34b2o6bo!
-    )";
-  loadrle(life, (xSize - x) / 2, (ySize - y) / 2, rle);
-  life->run();
-}
-
-void SirRobin(LEDMatrixLife* life) {
-  //#N Sir Robin
-  //#O Adam P. Goucher, Tom Rokicki; 2018
-  //#C The first elementary knightship to be found in Conway's Game of Life.
-  //#C https://conwaylife.com/wiki/Sir_Robin
-  int x = 31, y = 79; // rule = B3/S23
-  const char* rle = R"(
-    4b2o$4bo2bo$4bo3bo$6b3o$2b2o6b4o$2bob2o4b4o$bo4bo6b3o$2b4o4b2o3bo$o9b
-    2o$bo3bo$6b3o2b2o2bo$2b2o7bo4bo$13bob2o$10b2o6bo$11b2ob3obo$10b2o3bo2b
-    o$10bobo2b2o$10bo2bobobo$10b3o6bo$11bobobo3bo$14b2obobo$11bo6b3o2$11bo
-    9bo$11bo3bo6bo$12bo5b5o$12b3o$16b2o$13b3o2bo$11bob3obo$10bo3bo2bo$11bo
-    4b2ob3o$13b4obo4b2o$13bob4o4b2o$19bo$20bo2b2o$20b2o$21b5o$25b2o$19b3o
-    6bo$20bobo3bobo$19bo3bo3bo$19bo3b2o$18bo6bob3o$19b2o3bo3b2o$20b4o2bo2b
-    o$22b2o3bo$21bo$21b2obo$20bo$19b5o$19bo4bo$18b3ob3o$18bob5o$18bo$20bo$
-    16bo4b4o$20b4ob2o$17b3o4bo$24bobo$28bo$24bo2b2o$25b3o$22b2o$21b3o5bo$
-    24b2o2bobo$21bo2b3obobo$22b2obo2bo$24bobo2b2o$26b2o$22b3o4bo$22b3o4bo$
-    23b2o3b3o$24b2ob2o$25b2o$25bo2$24b2o$26bo!
-    )";
-  loadrle(life, 10 + (xSize - x) / 2, 10, rle);
-  life->setViewportSpeed(-20, -40, 120);
-  life->run();
-}
-
-void loadrle(LEDMatrixLife* life, int xOff, int yOff, Stream& in) {
-  life->clear();
-
-  int count = 0;
-  int x = xOff;
-  int y = yOff;
-  for (;;) {
-    int c = in.read();
-    if (c == '!' || c == 0 || c == -1) {
-      return;
-    } else if (c == ' ' || c == '\n' || c == '\t') {
-      continue;
-    } else if (c >= '0' && c <= '9') {
-      count = count * 10 + c - '0';
-    } else {
-      if (count == 0) count = 1;
-      if (c == 'b' || c == '.') {
-        x += count;
-      } else if (c == 'o') {
-        byte on = random(1, nDefaultColors);
-        for (int i = 0; i < count; i++) {
-          life->set(x, y, on);
-          x++;
-        }
-      } else if (c >= 'A' && c <= 'Z') {
-        byte on = 1 + c - 'A';
-        for (int i = 0; i < count; i++) {
-          life->set(x, y, on);
-          x++;
-        }
-      } else if (c == '$') {
-        y += count;
-        x = xOff;
-      }
-      count = 0;
-    }
-  }
-}
-
-void loadrle(LEDMatrixLife* life, int xOff, int yOff, const char* rle) {
-  CharStream stream(rle);
-  loadrle(life, xOff, yOff, stream);
-}
\ No newline at end of file
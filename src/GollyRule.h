@@ -0,0 +1,780 @@
+#ifndef GollyRule_h
+#define GollyRule_h
+
+#include "Platform.h"
+
+#include <algorithm>
+
+#include "CharStream.h"
+#include "Life.h"
+
+// Rules loaded from Golly rule files (https://golly.sourceforge.io/Help/formats.html),
+// in either the @TREE or the @TABLE format, for Moore or von Neumann
+// neighborhoods.
+//
+// Both are turned into a rule tree walked in our neighbor order (NW, N, NE, W,
+// E, SW, S, SE, C) like the built in TreeRules, so CompiledRule flattens them
+// in the same way. Identical nodes are shared, and nodes are stored in the
+// narrowest type that can index them.
+//
+//   GollyRule* rule = loadGollyRule(text);
+//   if (rule) life.setRule(rule->getNStates(), rule);
+
+class GollyRule : public TreeRule {
+public:
+  int getNStates() {
+    return nStates;
+  }
+  int getNodeCount() {
+    return nNodes;
+  }
+protected:
+  GollyRule(int nStates, int nNodes)
+    : nStates(nStates), nNodes(nNodes) {}
+  int nStates;
+  int nNodes;
+};
+
+// Each node has nStates entries: the next node, or for the nodes that take the
+// center cell, the new state. The root is the last node.
+template <class T>
+class GollyTreeRule : public GollyRule {
+public:
+  GollyTreeRule(int nStates, int nNodes, const int* nodes)
+    : GollyRule(nStates, nNodes) {
+    lookup = (T*)malloc(sizeof(T) * nNodes * nStates);
+    for (int i = 0; i < nNodes * nStates; i++) lookup[i] = nodes[i];
+  }
+  ~GollyTreeRule() {
+    free(lookup);
+  }
+  int transition(int* neighbors) {
+    const T* l = lookup;
+    const int s = nStates;
+    int node = nNodes - 1;
+    for (int i = 0; i < 9; i++) node = l[node * s + neighbors[i]];
+    return node;
+  }
+  int getTreeRoot() {
+    return nNodes - 1;
+  }
+  int getTreeNode(int node, int state) {
+    return lookup[node * nStates + state];
+  }
+private:
+  T* lookup;
+};
+
+// Store of nodes, each a tag and nStates children, in which identical nodes are
+// only stored once
+class NodeStore {
+public:
+  NodeStore(int nStates)
+    : nStates(nStates) {}
+  NodeStore(const NodeStore&) = delete;
+  ~NodeStore() {
+    free(tags);
+    free(children);
+    free(buckets);
+  }
+  int get(int tag, const int* kids) {
+    if (count * 2 >= nBuckets) grow();
+    for (uint32_t i = hash(tag, kids) & (nBuckets - 1);; i = (i + 1) & (nBuckets - 1)) {
+      int id = buckets[i];
+      if (id < 0) {
+        id = add(tag, kids);
+        buckets[i] = id;
+        return id;
+      }
+      if (tags[id] == tag && !memcmp(getChildren(id), kids, sizeof(int) * nStates)) return id;
+    }
+  }
+  int getTag(int id) {
+    return tags[id];
+  }
+  const int* getChildren(int id) {
+    return children + (long)id * nStates;
+  }
+  int size() {
+    return count;
+  }
+private:
+  uint32_t hash(int tag, const int* kids) {
+    uint32_t h = tag * 0x9E3779B1u;
+    for (int i = 0; i < nStates; i++) h = (h ^ kids[i]) * 0x85EBCA77u;
+    return h ^ (h >> 15);
+  }
+  int add(int tag, const int* kids) {
+    if (count == alloc) {
+      alloc = alloc ? alloc * 2 : 256;
+      tags = (int*)realloc(tags, sizeof(int) * alloc);
+      children = (int*)realloc(children, sizeof(int) * alloc * nStates);
+    }
+    tags[count] = tag;
+    memcpy(children + (long)count * nStates, kids, sizeof(int) * nStates);
+    return count++;
+  }
+  void grow() {
+    nBuckets = nBuckets ? nBuckets * 2 : 512;
+    free(buckets);
+    buckets = (int*)malloc(sizeof(int) * nBuckets);
+    memset(buckets, -1, sizeof(int) * nBuckets);
+    for (int id = 0; id < count; id++) {
+      uint32_t i = hash(tags[id], getChildren(id)) & (nBuckets - 1);
+      while (buckets[i] >= 0) i = (i + 1) & (nBuckets - 1);
+      buckets[i] = id;
+    }
+  }
+  int nStates;
+  int* tags = 0;
+  int* children = 0;
+  int count = 0;
+  int alloc = 0;
+  int* buckets = 0;
+  int nBuckets = 0;
+};
+
+// Map from 64 bit keys to ints, used to memoize tree transformations
+class NodeMemo {
+public:
+  NodeMemo() {}
+  NodeMemo(const NodeMemo&) = delete;
+  ~NodeMemo() {
+    free(keys);
+    free(values);
+  }
+  bool find(uint64_t key, int& value) {
+    if (!count) return false;
+    for (uint32_t i = slot(key);; i = (i + 1) & (nSlots - 1)) {
+      if (keys[i] == empty) return false;
+      if (keys[i] == key) {
+        value = values[i];
+        return true;
+      }
+    }
+  }
+  void insert(uint64_t key, int value) {
+    if (count * 2 >= nSlots) grow();
+    uint32_t i = slot(key);
+    while (keys[i] != empty) i = (i + 1) & (nSlots - 1);
+    keys[i] = key;
+    values[i] = value;
+    count++;
+  }
+private:
+  const static uint64_t empty = ~0ULL;
+  uint32_t slot(uint64_t key) {
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(key >> 32) & (nSlots - 1);
+  }
+  void grow() {
+    uint64_t* oldKeys = keys;
+    int* oldValues = values;
+    int oldSlots = nSlots;
+    nSlots = nSlots ? nSlots * 2 : 1024;
+    keys = (uint64_t*)malloc(sizeof(uint64_t) * nSlots);
+    values = (int*)malloc(sizeof(int) * nSlots);
+    memset(keys, 0xff, sizeof(uint64_t) * nSlots);
+    count = 0;
+    for (int i = 0; i < oldSlots; i++) {
+      if (oldKeys[i] != empty) insert(oldKeys[i], oldValues[i]);
+    }
+    free(oldKeys);
+    free(oldValues);
+  }
+  uint64_t* keys = 0;
+  int* values = 0;
+  int count = 0;
+  int nSlots = 0;
+};
+
+// Reads a Golly rule file a line at a time, dropping comments and surrounding
+// white space
+class GollyReader {
+public:
+  GollyReader(Stream& in)
+    : in(in) {}
+  // Returns false at the end of the input. Blank lines are skipped.
+  bool next() {
+    for (;;) {
+      int n = 0;
+      int c = in.read();
+      if (c == -1 || c == 0) return false;
+      bool comment = false;
+      for (; c != '\n' && c != -1 && c != 0; c = in.read()) {
+        if (c == '#') comment = true;
+        if (!comment && n < maxLine - 1) line[n++] = c;
+      }
+      while (n > 0 && isSpace(line[n - 1])) n--;
+      line[n] = 0;
+      start = line;
+      while (isSpace(*start)) start++;
+      if (*start) return true;
+    }
+  }
+  char* get() {
+    return start;
+  }
+  // If the line is "key<separator>value", returns the value
+  const char* value(const char* key, char separator) {
+    int n = strlen(key);
+    if (strncmp(start, key, n)) return 0;
+    const char* c = start + n;
+    while (isSpace(*c)) c++;
+    if (*c++ != separator) return 0;
+    while (isSpace(*c)) c++;
+    return c;
+  }
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+  }
+private:
+  const static int maxLine = 1024;
+  Stream& in;
+  char line[maxLine];
+  char* start = line;
+};
+
+// Turns a rule into a tree in our neighbor order, and builds the GollyTreeRule
+class GollyRuleBuilder {
+public:
+  GollyRuleBuilder(int nStates)
+    : nStates(nStates), tree(nStates) {}
+
+  // Node taking neighbor depth (0 to 8). Children are nodes taking the next
+  // neighbor, or for depth 8, states.
+  int node(int depth, const int* children) {
+    return tree.get(depth, children);
+  }
+  GollyRule* finish(int root) {
+    // The root is always the last node built
+    int nNodes = root + 1;
+    if (nNodes != tree.size() || nNodes > 65536) return 0;
+    const int* nodes = tree.getChildren(0);
+    if (nNodes <= 256) return new GollyTreeRule<uint8_t>(nStates, nNodes, nodes);
+    return new GollyTreeRule<uint16_t>(nStates, nNodes, nodes);
+  }
+  int getNStates() {
+    return nStates;
+  }
+private:
+  int nStates;
+  NodeStore tree;
+};
+
+// Golly's rule trees take the neighbors in the order nw, ne, sw, se, n, w, e, s,
+// c (or n, w, e, s, c for von Neumann). These are the matching indexes into our
+// neighbors.
+const int gollyMooreOrder[9] = { 0, 2, 5, 7, 1, 3, 4, 6, 8 };
+const int gollyVonNeumannOrder[5] = { 1, 3, 4, 6, 8 };
+
+// Reorders a Golly tree. The Golly tree is held as a decision diagram: each node
+// is tagged with the index of the neighbor it tests, and states s are -1 - s.
+// A node whose children are all the same is replaced by that child, so
+// neighbors that no longer matter drop out. We then fix our neighbors one at a
+// time, each fixed value giving a smaller diagram over the others.
+class GollyTreeReorder {
+public:
+  GollyTreeReorder(GollyRuleBuilder& builder)
+    : builder(builder), nStates(builder.getNStates()), diagram(nStates) {}
+
+  int make(int neighbor, const int* kids) {
+    for (int i = 1; i < nStates; i++) {
+      if (kids[i] != kids[0]) return diagram.get(neighbor, kids);
+    }
+    return kids[0];
+  }
+  // The diagram with neighbor fixed at value
+  int restrict(int f, int neighbor, int value) {
+    if (f < 0) return f;
+    uint64_t key = ((uint64_t)f << 16) | (neighbor << 8) | value;
+    int result;
+    if (memo.find(key, result)) return result;
+    int tag = diagram.getTag(f);
+    if (tag == neighbor) {
+      result = diagram.getChildren(f)[value];
+    } else {
+      int kids[256];
+      memcpy(kids, diagram.getChildren(f), sizeof(int) * nStates);
+      for (int i = 0; i < nStates; i++) kids[i] = restrict(kids[i], neighbor, value);
+      result = make(tag, kids);
+    }
+    memo.insert(key, result);
+    return result;
+  }
+  // Node of our tree taking neighbor depth, for the diagram f over neighbors
+  // depth and later
+  int build(int f, int depth) {
+    if (depth == 9) return f < 0 ? -1 - f : -1;
+    uint64_t key = ((uint64_t)(uint32_t)f << 8) | depth;
+    int result;
+    if (built.find(key, result)) return result;
+    int kids[256];
+    for (int v = 0; v < nStates; v++) {
+      kids[v] = build(restrict(f, depth, v), depth + 1);
+      if (kids[v] < 0) return -1;
+    }
+    result = builder.node(depth, kids);
+    built.insert(key, result);
+    return result;
+  }
+private:
+  GollyRuleBuilder& builder;
+  int nStates;
+  NodeStore diagram;
+  NodeMemo memo;
+  NodeMemo built;
+};
+
+inline GollyRule* loadGollyTree(GollyReader& reader) {
+  int nStates = 0, nNeighbors = 0, nNodes = 0;
+  while (reader.next()) {
+    const char* v;
+    if ((v = reader.value("num_states", '='))) {
+      nStates = atoi(v);
+    } else if ((v = reader.value("num_neighbors", '='))) {
+      nNeighbors = atoi(v);
+    } else if ((v = reader.value("num_nodes", '='))) {
+      nNodes = atoi(v);
+      break;
+    } else {
+      return 0;
+    }
+  }
+  if (nStates < 2 || nStates > 256 || nNodes < 1) return 0;
+  const int* order;
+  if (nNeighbors == 8) {
+    order = gollyMooreOrder;
+  } else if (nNeighbors == 4) {
+    order = gollyVonNeumannOrder;
+  } else {
+    return 0;
+  }
+  int nLevels = nNeighbors + 1;
+  GollyRuleBuilder builder(nStates);
+  GollyTreeReorder reorder(builder);
+  int* ids = (int*)malloc(sizeof(int) * nNodes);
+  int kids[256];
+  int n = 0;
+  while (n < nNodes && reader.next()) {
+    if (*reader.get() == '@') break;
+    char* c = reader.get();
+    int level = strtol(c, &c, 10);
+    if (level < 1 || level > nLevels) break;
+    int i = 0;
+    for (; i < nStates; i++) {
+      char* end;
+      int child = strtol(c, &end, 10);
+      if (end == c) break;
+      c = end;
+      if (level == 1) {
+        if (child < 0 || child >= nStates) break;
+        kids[i] = -1 - child;
+      } else {
+        if (child < 0 || child >= n) break;
+        kids[i] = ids[child];
+      }
+    }
+    if (i < nStates) break;
+    ids[n++] = reorder.make(order[nLevels - level], kids);
+  }
+  int root = n == nNodes ? reorder.build(ids[n - 1], 0) : -1;
+  free(ids);
+  return root < 0 ? 0 : builder.finish(root);
+}
+
+// A transition of a @TABLE, expanded so that it has no bound variables: the
+// states each of our neighbors may have, and the new state
+struct GollyTableLine {
+  uint64_t in[9];
+  int out;
+};
+
+class GollyTable {
+public:
+  GollyTable(int nStates, int nNeighbors)
+    : nStates(nStates), nNeighbors(nNeighbors) {}
+  GollyTable(const GollyTable&) = delete;
+  ~GollyTable() {
+    free(lines);
+    free(vars);
+    free(sets);
+    free(setPool);
+  }
+  bool setSymmetries(const char* name) {
+    int ringSize = nNeighbors;
+    reflect = false;
+    if (!strcmp(name, "none")) {
+      rotations = 1;
+    } else if (!strcmp(name, "rotate2")) {
+      rotations = 2;
+    } else if (!strcmp(name, "rotate4")) {
+      rotations = 4;
+    } else if (!strcmp(name, "rotate8") && ringSize == 8) {
+      rotations = 8;
+    } else if (!strcmp(name, "reflect_horizontal") || !strcmp(name, "reflect")) {
+      rotations = 1;
+      reflect = true;
+    } else if (!strcmp(name, "rotate4reflect")) {
+      rotations = 4;
+      reflect = true;
+    } else if (!strcmp(name, "rotate8reflect") && ringSize == 8) {
+      rotations = 8;
+      reflect = true;
+    } else if (!strcmp(name, "permute")) {
+      permute = true;
+    } else {
+      return false;
+    }
+    return true;
+  }
+  // "var name={...}", where the values may be states or earlier variables
+  bool addVariable(const char* text) {
+    char name[32];
+    int n = 0;
+    while (*text && *text != '=' && !GollyReader::isSpace(*text)) {
+      if (n < 31) name[n++] = *text;
+      text++;
+    }
+    name[n] = 0;
+    while (GollyReader::isSpace(*text)) text++;
+    if (n == 0 || *text++ != '=') return false;
+    while (GollyReader::isSpace(*text)) text++;
+    if (*text++ != '{') return false;
+    uint64_t mask = 0;
+    char token[32];
+    while (nextToken(text, token, ",}")) {
+      uint64_t m = lookup(token);
+      if (!m) return false;
+      mask |= m;
+    }
+    if (*text != '}' || !mask) return false;
+    if (nVars == varAlloc) {
+      varAlloc = varAlloc ? varAlloc * 2 : 16;
+      vars = (Variable*)realloc(vars, sizeof(Variable) * varAlloc);
+    }
+    strcpy(vars[nVars].name, name);
+    vars[nVars++].mask = mask;
+    return true;
+  }
+  // A transition, in Golly's order C, N, NE, E, SE, S, SW, W, NW, C' (or C, N,
+  // E, S, W, C' for von Neumann), with or without commas
+  bool addTransition(const char* text) {
+    // Our neighbor index for each of Golly's inputs
+    static const int moore[9] = { 8, 1, 2, 4, 7, 6, 5, 3, 0 };
+    static const int vonNeumann[5] = { 8, 1, 4, 6, 3 };
+    const int* position = nNeighbors == 8 ? moore : vonNeumann;
+    int nInputs = nNeighbors + 1;
+    char tokens[10][32];
+    bool commas = strchr(text, ',') != 0;
+    int n = 0;
+    while (n < nInputs + 1) {
+      if (commas) {
+        if (!nextToken(text, tokens[n], ",")) break;
+        n++;
+        if (*text == ',') text++;
+      } else {
+        while (GollyReader::isSpace(*text)) text++;
+        if (!*text) break;
+        tokens[n][0] = *text++;
+        tokens[n++][1] = 0;
+      }
+    }
+    while (GollyReader::isSpace(*text)) text++;
+    if (n != nInputs + 1 || *text) return false;
+    // Variables appearing more than once are bound, and take each of their
+    // values in turn
+    uint64_t masks[10] = {};
+    int bound[10];
+    int nBound = 0;
+    int boundIndex[10] = {};
+    for (int i = 0; i <= nInputs; i++) {
+      boundIndex[i] = -1;
+      masks[i] = lookup(tokens[i]);
+      if (!masks[i]) return false;
+      if (isNumber(tokens[i])) continue;
+      for (int j = 0; j <= nInputs; j++) {
+        if (j != i && !strcmp(tokens[i], tokens[j])) {
+          int b = 0;
+          while (b < nBound && strcmp(tokens[bound[b]], tokens[i])) b++;
+          if (b == nBound) bound[nBound++] = i;
+          boundIndex[i] = b;
+          break;
+        }
+      }
+    }
+    // The output must be a single state
+    if (boundIndex[nInputs] < 0 && (masks[nInputs] & (masks[nInputs] - 1))) return false;
+    uint64_t boundMasks[10];
+    for (int b = 0; b < nBound; b++) boundMasks[b] = masks[bound[b]];
+    addSymmetric(position, masks, boundIndex, boundMasks, nBound);
+    return true;
+  }
+
+  // Build our tree from the transitions, the first one to match deciding the
+  // new state, and cells that match none staying the same
+  GollyRule* build() {
+    GollyRuleBuilder builder(nStates);
+    int* set = (int*)malloc(sizeof(int) * (nLines + 1));
+    for (int i = 0; i < nLines; i++) set[i] = i;
+    int root = build(builder, set, nLines, 0);
+    free(set);
+    return root < 0 ? 0 : builder.finish(root);
+  }
+  int getNStates() {
+    return nStates;
+  }
+
+private:
+  struct Variable {
+    char name[32];
+    uint64_t mask;
+  };
+  // A set of lines already built at some depth
+  struct SetEntry {
+    int depth;
+    int offset;
+    int length;
+    int node;
+  };
+
+  static bool isNumber(const char* token) {
+    for (; *token; token++) {
+      if (*token < '0' || *token > '9') return false;
+    }
+    return true;
+  }
+  // Copies the next token before one of the delimiters into token
+  static bool nextToken(const char*& text, char* token, const char* delimiters) {
+    while (GollyReader::isSpace(*text) || (*text == ',' && strchr(delimiters, ','))) text++;
+    int n = 0;
+    while (*text && !strchr(delimiters, *text) && !GollyReader::isSpace(*text)) {
+      if (n < 31) token[n++] = *text;
+      text++;
+    }
+    token[n] = 0;
+    while (GollyReader::isSpace(*text)) text++;
+    return n > 0;
+  }
+  // Mask of the states a token stands for, or 0 if it is not understood
+  uint64_t lookup(const char* token) {
+    if (isNumber(token)) {
+      int state = atoi(token);
+      return state < nStates ? 1ULL << state : 0;
+    }
+    for (int i = nVars - 1; i >= 0; i--) {
+      if (!strcmp(vars[i].name, token)) return vars[i].mask;
+    }
+    return 0;
+  }
+  // Add each arrangement of the neighbors allowed by the symmetries. Golly's
+  // inputs 1 to nNeighbors go clockwise from N, so the symmetries rotate and
+  // reflect them.
+  void addSymmetric(const int* position, const uint64_t* masks, const int* boundIndex, const uint64_t* boundMasks,
+                    int nBound) {
+    int r = nNeighbors;
+    uint64_t variantMasks[10];
+    int variantBound[10];
+    memcpy(variantMasks, masks, sizeof(variantMasks));
+    memcpy(variantBound, boundIndex, sizeof(variantBound));
+    if (permute) {
+      // Inputs with the same token get the same id, so each distinct arrangement
+      // is only made once
+      int ids[8];
+      for (int i = 0; i < r; i++) {
+        int id = 0;
+        while (masks[1 + id] != masks[1 + i] || boundIndex[1 + id] != boundIndex[1 + i]) id++;
+        int j = i;
+        for (; j > 0 && ids[j - 1] > id; j--) ids[j] = ids[j - 1];
+        ids[j] = id;
+      }
+      do {
+        for (int i = 0; i < r; i++) {
+          variantMasks[1 + i] = masks[1 + ids[i]];
+          variantBound[1 + i] = boundIndex[1 + ids[i]];
+        }
+        int values[10];
+        expandBound(position, variantMasks, variantBound, boundMasks, nBound, values, 0);
+      } while (std::next_permutation(ids, ids + r));
+      return;
+    }
+    // Symmetric transitions give the same arrangement more than once
+    uint64_t seenMasks[16][8];
+    int seenBound[16][8];
+    int nSeen = 0;
+    for (int flip = 0; flip <= (reflect ? 1 : 0); flip++) {
+      for (int rotation = 0; rotation < rotations; rotation++) {
+        int step = rotation * r / rotations;
+        for (int i = 0; i < r; i++) {
+          int from = flip ? (r - i) % r : i;
+          variantMasks[1 + (i + step) % r] = masks[1 + from];
+          variantBound[1 + (i + step) % r] = boundIndex[1 + from];
+        }
+        bool seen = false;
+        for (int j = 0; j < nSeen && !seen; j++) {
+          seen = !memcmp(seenMasks[j], variantMasks + 1, sizeof(uint64_t) * r) &&
+                 !memcmp(seenBound[j], variantBound + 1, sizeof(int) * r);
+        }
+        if (seen) continue;
+        memcpy(seenMasks[nSeen], variantMasks + 1, sizeof(uint64_t) * r);
+        memcpy(seenBound[nSeen++], variantBound + 1, sizeof(int) * r);
+        int values[10];
+        expandBound(position, variantMasks, variantBound, boundMasks, nBound, values, 0);
+      }
+    }
+  }
+  // Add a line for each combination of values of the bound variables
+  void expandBound(const int* position, const uint64_t* masks, const int* boundIndex, const uint64_t* boundMasks,
+                   int nBound, int* values, int b) {
+    if (b < nBound) {
+      for (int v = 0; v < nStates; v++) {
+        if (!(boundMasks[b] & (1ULL << v))) continue;
+        values[b] = v;
+        expandBound(position, masks, boundIndex, boundMasks, nBound, values, b + 1);
+      }
+      return;
+    }
+    GollyTableLine line;
+    int nInputs = nNeighbors + 1;
+    for (int i = 0; i < 9; i++) line.in[i] = ~0ULL;
+    for (int i = 0; i < nInputs; i++) {
+      line.in[position[i]] = boundIndex[i] >= 0 ? 1ULL << values[boundIndex[i]] : masks[i];
+    }
+    line.out = boundIndex[nInputs] >= 0 ? values[boundIndex[nInputs]] : __builtin_ctzll(masks[nInputs]);
+    addLine(line);
+  }
+  void addLine(const GollyTableLine& line) {
+    if (nLines == lineAlloc) {
+      lineAlloc = lineAlloc ? lineAlloc * 2 : 256;
+      lines = (GollyTableLine*)realloc(lines, sizeof(GollyTableLine) * lineAlloc);
+    }
+    lines[nLines++] = line;
+  }
+
+  // Node taking neighbor depth, given the lines that still match. Many
+  // neighborhoods leave the same lines, so the node for each set is remembered.
+  int build(GollyRuleBuilder& builder, const int* set, int n, int depth) {
+    uint64_t key = depth;
+    for (int i = 0; i < n; i++) key = (key ^ set[i]) * 0x100000001B3ULL;
+    if (key == ~0ULL) key = 0;
+    int known;
+    if (built.find(key, known)) {
+      SetEntry& e = sets[known];
+      if (e.depth == depth && e.length == n && (n == 0 || !memcmp(setPool + e.offset, set, sizeof(int) * n))) return e.node;
+    }
+    int kids[64];
+    int* subset = (int*)malloc(sizeof(int) * (n + 1));
+    for (int v = 0; v < nStates; v++) {
+      int m = 0;
+      for (int i = 0; i < n; i++) {
+        if (lines[set[i]].in[depth] & (1ULL << v)) subset[m++] = set[i];
+      }
+      if (depth == 8) {
+        kids[v] = m ? lines[subset[0]].out : v;
+      } else {
+        kids[v] = build(builder, subset, m, depth + 1);
+      }
+    }
+    free(subset);
+    int node = builder.node(depth, kids);
+    if (!built.find(key, known)) {
+      built.insert(key, nSets);
+      remember(depth, set, n, node);
+    }
+    return node;
+  }
+  void remember(int depth, const int* set, int n, int node) {
+    if (nSets == setAlloc) {
+      setAlloc = setAlloc ? setAlloc * 2 : 256;
+      sets = (SetEntry*)realloc(sets, sizeof(SetEntry) * setAlloc);
+    }
+    if (poolLength + n > poolAlloc) {
+      poolAlloc = max(poolAlloc * 2, poolLength + n + 1024);
+      setPool = (int*)realloc(setPool, sizeof(int) * poolAlloc);
+    }
+    // The pool may not exist yet if the first set is empty
+    if (n) memcpy(setPool + poolLength, set, sizeof(int) * n);
+    sets[nSets++] = { depth, poolLength, n, node };
+    poolLength += n;
+  }
+
+  int nStates;
+  int nNeighbors;
+  int rotations = 1;
+  bool reflect = false;
+  bool permute = false;
+  Variable* vars = 0;
+  int nVars = 0;
+  int varAlloc = 0;
+  GollyTableLine* lines = 0;
+  int nLines = 0;
+  int lineAlloc = 0;
+  NodeMemo built;
+  SetEntry* sets = 0;
+  int nSets = 0;
+  int setAlloc = 0;
+  int* setPool = 0;
+  int poolLength = 0;
+  int poolAlloc = 0;
+};
+
+inline GollyRule* loadGollyTable(GollyReader& reader) {
+  int nStates = 0, nNeighbors = 0;
+  GollyTable* table = 0;
+  GollyRule* rule = 0;
+  bool ok = true;
+  while (ok && reader.next()) {
+    const char* line = reader.get();
+    if (*line == '@') break;
+    const char* v;
+    if ((v = reader.value("n_states", ':'))) {
+      nStates = atoi(v);
+    } else if ((v = reader.value("neighborhood", ':'))) {
+      if (!strcmp(v, "Moore")) {
+        nNeighbors = 8;
+      } else if (!strcmp(v, "vonNeumann")) {
+        nNeighbors = 4;
+      } else {
+        ok = false;
+      }
+    } else {
+      // The header is done once the first variable, symmetry or transition is seen
+      if (!table) {
+        if (nStates < 2 || nStates > 64 || !nNeighbors) {
+          ok = false;
+          break;
+        }
+        table = new GollyTable(nStates, nNeighbors);
+      }
+      if ((v = reader.value("symmetries", ':'))) {
+        ok = table->setSymmetries(v);
+      } else if (!strncmp(line, "var", 3) && GollyReader::isSpace(line[3])) {
+        ok = table->addVariable(line + 4);
+      } else {
+        ok = table->addTransition(line);
+      }
+    }
+  }
+  if (ok && table) rule = table->build();
+  delete table;
+  return rule;
+}
+
+// Load the first @TREE or @TABLE in a Golly .rule file. Returns 0 if there is
+// none, or it can't be read.
+inline GollyRule* loadGollyRule(Stream& in) {
+  GollyReader reader(in);
+  while (reader.next()) {
+    const char* line = reader.get();
+    if (!strcmp(line, "@TREE")) return loadGollyTree(reader);
+    if (!strcmp(line, "@TABLE")) return loadGollyTable(reader);
+  }
+  return 0;
+}
+
+inline GollyRule* loadGollyRule(const char* text) {
+  CharStream in(text);
+  return loadGollyRule(in);
+}
+
+#endif
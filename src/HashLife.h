@@ -0,0 +1,419 @@
+#ifndef HashLife_h
+#define HashLife_h
+
+#include "Life.h"
+
+// https://conwaylife.com/wiki/HashLife
+//
+// The universe is stored as a quadtree in which identical sub-trees are shared
+// (every node is looked up in a hash table before being created), and the
+// future of each node is memoized. Level 0 nodes are the cell states
+// themselves, so node indexes 0..nStates-1 are the leaves. A node at level k
+// covers 2^k x 2^k cells, and its result is the central 2^(k-1) x 2^(k-1)
+// square advanced min(2^(k-2), 2^stepLog) generations.
+//
+// Works for any TreeRule (including multi-state rules such as NiemiecTreeRule and
+// GenerationsTreeRule), as long as the rule maps an all dead neighborhood to 0.
+class HashLife : public Life {
+public:
+  HashLife(int nStates, TreeRule* treeRule, int maxNodes = 1 << 16)
+    : maxNodes(maxNodes) {
+    setRule(nStates, treeRule);
+  }
+  ~HashLife() {
+    free(nodes);
+    free(buckets);
+  }
+  virtual void setRule(int nStates, TreeRule* rule) {
+    this->nStates = nStates;
+    treeRule = rule;
+    compiledRule.compile(nStates, rule);
+    clear();
+  }
+  virtual void clear() {
+    resetTable(initialBuckets);
+    root = empty(3);
+    generation = 0;
+  }
+  virtual void set(int x, int y, byte value) {
+    while (!contains(x, y)) expand();
+    int level = nodes[root].level;
+    long long half = 1LL << (level - 1);
+    root = set(root, level, x + half, y + half, value);
+  }
+  byte get(int x, int y) {
+    if (!contains(x, y)) return 0;
+    int level = nodes[root].level;
+    long long half = 1LL << (level - 1);
+    long long lx = x + half;
+    long long ly = y + half;
+    uint32_t n = root;
+    for (; level > 0; level--) {
+      long long h = 1LL << (level - 1);
+      const Node& node = nodes[n];
+      n = ly < h ? (lx < h ? node.nw : node.ne) : (lx < h ? node.sw : node.se);
+      if (lx >= h) lx -= h;
+      if (ly >= h) ly -= h;
+    }
+    return n;
+  }
+  virtual void nextGeneration() {
+    advance(1);
+  }
+  // Advance n generations, as a series of jumps of 2^k generations, one for each
+  // bit set in n. Each jump costs about the same, however large k is, as long as
+  // the pattern is regular enough for the memoized results to be reused.
+  void advance(unsigned long n) {
+    for (int k = 0; n != 0; k++, n >>= 1) {
+      if (n & 1) jump(k);
+    }
+  }
+  unsigned long long getGeneration() {
+    return generation;
+  }
+  int getNodeCount() {
+    return nodeCount;
+  }
+  int getNStates() {
+    return nStates;
+  }
+  virtual size_t getStateBytes() {
+    return sizeof(Node) * nodeAlloc + sizeof(uint32_t) * nBuckets;
+  }
+  virtual void iterateLiveRuns(RunVisitor& visitor) {
+    int level = nodes[root].level;
+    long long half = 1LL << (level - 1);
+    iterateLiveRuns(root, level, -half, -half, visitor);
+  }
+
+  // The quadtree itself, for reading and writing macrocell files (see
+  // Macrocell.h). Nodes 0 to nStates - 1 are the leaves, and the root's
+  // center is at (0, 0). Node numbers are only good until the next step,
+  // which may garbage collect.
+  uint32_t getRoot() {
+    return root;
+  }
+  int getLevel(uint32_t n) {
+    return nodes[n].level;
+  }
+  void getChildren(uint32_t n, uint32_t children[4]) {
+    const Node& c = nodes[n];
+    children[0] = c.nw;
+    children[1] = c.ne;
+    children[2] = c.sw;
+    children[3] = c.se;
+  }
+  uint32_t makeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    return node(nw, ne, sw, se);
+  }
+  uint32_t emptyNode(int level) {
+    return empty(level);
+  }
+  // Replace the universe with the tree under n, at level 1 or more
+  void setRoot(uint32_t n) {
+    root = n;
+    while (nodes[root].level < blockLevel) expand();
+    generation = 0;
+  }
+
+private:
+  static const uint32_t none = 0xffffffff;
+  static const int initialBuckets = 1 << 12;
+  static const int maxLevel = 62;
+  static const int blockLevel = 3;
+
+  struct Node {
+    uint32_t nw, ne, sw, se;
+    uint32_t result;  // Memoized result, or none
+    uint32_t chain;   // Next node in the same hash bucket, or none
+    byte level;
+    byte resultLog;   // log2 of the generations result was advanced
+  };
+
+  // Advance 2^k generations
+  void jump(int k) {
+    stepLog = k;
+    // Make sure nothing can escape the area covered by the result
+    while (nodes[root].level < k + 2 || !isCentered(root)) expand();
+    expand();
+    root = successor(root);
+    generation += 1ULL << k;
+    if (nodeCount > maxNodes) collect();
+  }
+
+  bool contains(int x, int y) {
+    long long half = 1LL << (nodes[root].level - 1);
+    return x >= -half && x < half && y >= -half && y < half;
+  }
+
+  // True if only the central half of the node is populated
+  bool isCentered(uint32_t n) {
+    // empty() may add nodes and move the table, so take copies first
+    Node c = nodes[n];
+    uint32_t e = empty(c.level - 2);
+    Node nw = nodes[c.nw];
+    Node ne = nodes[c.ne];
+    Node sw = nodes[c.sw];
+    Node se = nodes[c.se];
+    return nw.nw == e && nw.ne == e && nw.sw == e &&
+           ne.nw == e && ne.ne == e && ne.se == e &&
+           sw.nw == e && sw.sw == e && sw.se == e &&
+           se.ne == e && se.sw == e && se.se == e;
+  }
+
+  // Double the size of the universe, keeping the existing pattern in the middle
+  void expand() {
+    Node r = nodes[root];
+    assert(r.level < maxLevel);
+    uint32_t e = empty(r.level - 1);
+    uint32_t nw = node(e, e, e, r.nw);
+    uint32_t ne = node(e, e, r.ne, e);
+    uint32_t sw = node(e, r.sw, e, e);
+    uint32_t se = node(r.se, e, e, e);
+    root = node(nw, ne, sw, se);
+  }
+
+  uint32_t set(uint32_t n, int level, long long x, long long y, byte value) {
+    if (level == 0) return value;
+    long long h = 1LL << (level - 1);
+    Node c = nodes[n];
+    if (y < h) {
+      if (x < h) c.nw = set(c.nw, level - 1, x, y, value);
+      else c.ne = set(c.ne, level - 1, x - h, y, value);
+    } else {
+      if (x < h) c.sw = set(c.sw, level - 1, x, y - h, value);
+      else c.se = set(c.se, level - 1, x - h, y - h, value);
+    }
+    return node(c.nw, c.ne, c.sw, c.se);
+  }
+
+  // Non-empty nodes are walked down to 8x8 blocks, which are visited a row at a time
+  void iterateLiveRuns(uint32_t n, int level, long long x, long long y, RunVisitor& visitor) {
+    if (n == empty(level)) return;
+    if (level <= blockLevel) {
+      byte cells[1 << blockLevel][1 << blockLevel];
+      int size = 1 << level;
+      fill(n, level, cells, 0, 0);
+      for (int row = 0; row < size; row++) {
+        visitor.visit(x, y + row, size, cells[row]);
+      }
+      return;
+    }
+    Node c = nodes[n];
+    long long h = 1LL << (level - 1);
+    iterateLiveRuns(c.nw, level - 1, x, y, visitor);
+    iterateLiveRuns(c.ne, level - 1, x + h, y, visitor);
+    iterateLiveRuns(c.sw, level - 1, x, y + h, visitor);
+    iterateLiveRuns(c.se, level - 1, x + h, y + h, visitor);
+  }
+
+  void fill(uint32_t n, int level, byte cells[][1 << blockLevel], int x, int y) {
+    if (level == 0) {
+      cells[y][x] = n;
+      return;
+    }
+    const Node& c = nodes[n];
+    int h = 1 << (level - 1);
+    fill(c.nw, level - 1, cells, x, y);
+    fill(c.ne, level - 1, cells, x + h, y);
+    fill(c.sw, level - 1, cells, x, y + h);
+    fill(c.se, level - 1, cells, x + h, y + h);
+  }
+
+  // The central 2^(k-1) square of a node at level k >= 2, advanced
+  // min(2^(k-2), 2^stepLog) generations. Results are kept with the step they
+  // were made for, so jumps of different sizes only recompute the nodes whose
+  // step differs, those above level stepLog + 2.
+  uint32_t successor(uint32_t n) {
+    Node c = nodes[n];
+    int log = min(c.level - 2, stepLog);
+    if (c.result != none && c.resultLog == log) return c.result;
+    uint32_t result;
+    if (n == empty(c.level)) {
+      result = empty(c.level - 1);
+    } else if (c.level == 2) {
+      result = successor2(c);
+    } else {
+      Node nw = nodes[c.nw];
+      Node ne = nodes[c.ne];
+      Node sw = nodes[c.sw];
+      Node se = nodes[c.se];
+      // Nine overlapping nodes one level down
+      uint32_t n00 = c.nw;
+      uint32_t n01 = node(nw.ne, ne.nw, nw.se, ne.sw);
+      uint32_t n02 = c.ne;
+      uint32_t n10 = node(nw.sw, nw.se, sw.nw, sw.ne);
+      uint32_t n11 = node(nw.se, ne.sw, sw.ne, se.nw);
+      uint32_t n12 = node(ne.sw, ne.se, se.nw, se.ne);
+      uint32_t n20 = c.sw;
+      uint32_t n21 = node(sw.ne, se.nw, sw.se, se.sw);
+      uint32_t n22 = c.se;
+      // At full speed both halves of the step advance time, otherwise only the second one does
+      bool fast = stepLog >= c.level - 2;
+      uint32_t r00 = fast ? successor(n00) : center(n00);
+      uint32_t r01 = fast ? successor(n01) : center(n01);
+      uint32_t r02 = fast ? successor(n02) : center(n02);
+      uint32_t r10 = fast ? successor(n10) : center(n10);
+      uint32_t r11 = fast ? successor(n11) : center(n11);
+      uint32_t r12 = fast ? successor(n12) : center(n12);
+      uint32_t r20 = fast ? successor(n20) : center(n20);
+      uint32_t r21 = fast ? successor(n21) : center(n21);
+      uint32_t r22 = fast ? successor(n22) : center(n22);
+      result = node(successor(node(r00, r01, r10, r11)), successor(node(r01, r02, r11, r12)),
+                    successor(node(r10, r11, r20, r21)), successor(node(r11, r12, r21, r22)));
+    }
+    nodes[n].result = result;
+    nodes[n].resultLog = log;
+    return result;
+  }
+
+  // Base case, a 4x4 node stepped one generation using the rule
+  uint32_t successor2(const Node& c) {
+    int g[4][4];
+    const uint32_t quadrants[4] = { c.nw, c.ne, c.sw, c.se };
+    for (int q = 0; q < 4; q++) {
+      const Node& leaf = nodes[quadrants[q]];
+      int x = (q & 1) * 2;
+      int y = (q >> 1) * 2;
+      g[y][x] = leaf.nw;
+      g[y][x + 1] = leaf.ne;
+      g[y + 1][x] = leaf.sw;
+      g[y + 1][x + 1] = leaf.se;
+    }
+    uint32_t r[4];
+    for (int i = 0; i < 4; i++) {
+      int x = 1 + (i & 1);
+      int y = 1 + (i >> 1);
+      // Use the same order as SimpleLife
+      int neighbors[] = {
+        g[y - 1][x - 1], g[y - 1][x], g[y - 1][x + 1],
+        g[y][x - 1], g[y][x + 1],
+        g[y + 1][x - 1], g[y + 1][x], g[y + 1][x + 1],
+        g[y][x]
+      };
+      r[i] = compiledRule.transition(neighbors);
+    }
+    return node(r[0], r[1], r[2], r[3]);
+  }
+
+  // The central half of a node at level k >= 2
+  uint32_t center(uint32_t n) {
+    Node c = nodes[n];
+    return node(nodes[c.nw].se, nodes[c.ne].sw, nodes[c.sw].ne, nodes[c.se].nw);
+  }
+
+  uint32_t empty(int level) {
+    if (level == 0) return 0;
+    if (emptyNodes[level] == none) {
+      uint32_t e = empty(level - 1);
+      emptyNodes[level] = node(e, e, e, e);
+    }
+    return emptyNodes[level];
+  }
+
+  // Find or create the canonical node with the given children
+  uint32_t node(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t h = hash(nw, ne, sw, se) & (nBuckets - 1);
+    for (uint32_t n = buckets[h]; n != none; n = nodes[n].chain) {
+      const Node& c = nodes[n];
+      if (c.nw == nw && c.ne == ne && c.sw == sw && c.se == se) return n;
+    }
+    if (nodeCount == nodeAlloc) {
+      nodeAlloc *= 2;
+      nodes = (Node*)realloc(nodes, sizeof(Node) * nodeAlloc);
+      assert(nodes);
+    }
+    if (nodeCount > nBuckets) {
+      rehash(nBuckets * 2);
+      h = hash(nw, ne, sw, se) & (nBuckets - 1);
+    }
+    uint32_t n = nodeCount++;
+    Node& c = nodes[n];
+    c.nw = nw;
+    c.ne = ne;
+    c.sw = sw;
+    c.se = se;
+    c.result = none;
+    c.level = nodes[nw].level + 1;
+    c.chain = buckets[h];
+    buckets[h] = n;
+    return n;
+  }
+
+  static uint32_t hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t h = nw * 0x9E3779B1u + ne * 0x85EBCA77u + sw * 0xC2B2AE3Du + se * 0x27D4EB2Fu;
+    return h ^ (h >> 15);
+  }
+
+  void rehash(int newBuckets) {
+    nBuckets = newBuckets;
+    buckets = (uint32_t*)realloc(buckets, sizeof(uint32_t) * nBuckets);
+    assert(buckets);
+    for (int i = 0; i < nBuckets; i++) buckets[i] = none;
+    for (int n = nStates; n < nodeCount; n++) {
+      Node& c = nodes[n];
+      uint32_t h = hash(c.nw, c.ne, c.sw, c.se) & (nBuckets - 1);
+      c.chain = buckets[h];
+      buckets[h] = n;
+    }
+  }
+
+  // Start again with just the leaves
+  void resetTable(int newBuckets) {
+    if (!nodes) {
+      nodeAlloc = initialBuckets;
+      nodes = (Node*)malloc(sizeof(Node) * nodeAlloc);
+      assert(nodes);
+    }
+    for (int i = 0; i < nStates; i++) {
+      Node& leaf = nodes[i];
+      leaf.nw = leaf.ne = leaf.sw = leaf.se = none;
+      leaf.result = none;
+      leaf.chain = none;
+      leaf.level = 0;
+    }
+    nodeCount = nStates;
+    for (int level = 0; level <= maxLevel; level++) emptyNodes[level] = none;
+    rehash(newBuckets);
+  }
+
+  // Garbage collection: rebuild the table with only the nodes reachable from
+  // the root. Memoized results are dropped.
+  void collect() {
+    Node* old = nodes;
+    int oldCount = nodeCount;
+    uint32_t* map = (uint32_t*)malloc(sizeof(uint32_t) * oldCount);
+    assert(map);
+    for (int i = 0; i < oldCount; i++) map[i] = i < nStates ? i : none;
+    nodes = 0;
+    resetTable(nBuckets);
+    root = copy(old, map, root);
+    free(map);
+    free(old);
+    // Avoid collecting over and over again if most nodes are still in use
+    if (nodeCount > maxNodes / 2) maxNodes *= 2;
+  }
+
+  uint32_t copy(const Node* old, uint32_t* map, uint32_t n) {
+    if (map[n] == none) {
+      const Node& c = old[n];
+      map[n] = node(copy(old, map, c.nw), copy(old, map, c.ne), copy(old, map, c.sw), copy(old, map, c.se));
+    }
+    return map[n];
+  }
+
+  int nStates;
+  TreeRule* treeRule;
+  CompiledRule compiledRule;
+  int maxNodes;
+  Node* nodes = 0;
+  int nodeCount = 0;
+  int nodeAlloc = 0;
+  uint32_t* buckets = 0;
+  int nBuckets = 0;
+  uint32_t emptyNodes[maxLevel + 1];
+  uint32_t root;
+  int stepLog = 0;
+  unsigned long long generation;
+};
+#endif
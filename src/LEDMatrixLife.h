@@ -5,13 +5,25 @@
 #include <SmartMatrix.h>
 
 #include "Life.h"
+#include "Telemetry.h"
 
 class LEDMatrixLife {
    public:
+    // matrixWidth is the row length of the layer's buffer, which rows are
+    // written to directly (the layer must not be rotated)
     LEDMatrixLife(Life &implementation,
-                  SMLayerBackground<rgb24, 0U> *backgroundLayer)
+                  SMLayerBackground<rgb24, 0U> *backgroundLayer,
+                  int matrixWidth = 64)
         : lifeImplementation(implementation),
-          backgroundLayer(backgroundLayer) {}
+          backgroundLayer(backgroundLayer),
+          matrixWidth(matrixWidth) {
+        allocateFrames();
+    }
+
+    ~LEDMatrixLife() {
+        free(shown);
+        free(frame);
+    }
 
     // methods
     virtual void clear() { lifeImplementation.clear(); }
@@ -24,55 +36,78 @@ class LEDMatrixLife {
         lifeImplementation.set(x, y, value);
     }
 
+    Life &getLife() { return lifeImplementation; }
+
+    // Generations are shown at a fixed frame period (speed). Each generation is
+    // computed as soon as the previous one has been handed to the display, so
+    // the simulation overlaps the time it is on screen rather than adding to it.
     virtual void run() {
-        backgroundLayer->fillScreen(colors[0]);
-        lifeImplementation.iterateLive([this](int x, int y, int on) {
-            if (x >= 0 && x < xViewportSize && y >= 0 && y < yViewportSize) {
-                backgroundLayer->drawPixel(x, y, colors[on]);
-            }
-        });
-        backgroundLayer->swapBuffers(true);
-        delay(initialDelay);
-        int lastcrc = 0;
-        int looksDead = 0;
+        shownValid = false;
+        draw(0, 0);
+        swapBuffers();
+        waitUntil(millis() + initialDelay);
+        // The run ends once the whole state has been repeating for cycleHold
+        // generations. So does a still viewport whose contents repeat while the
+        // population isn't growing, as when only gliders are left flying off;
+        // a gun's or puffer's window repeats too, but it keeps growing.
+        stateCycles.clear();
+        windowCycles.clear();
+        stateCycles.add(lifeImplementation.getHash());
+        windowCycles.add(shownHash());
+        int cycleStart = -1;
+        int period = 0;
+        long cyclePopulation = 0;
         int xMin = xViewportMin;
         int yMin = yViewportMin;
+        int frames = 0;
+        missedFrames = 0;
+        unsigned long deadline = millis();
+        nextGeneration();
         for (int l = 1; l <= 8000; l++) {
-            delay(speed);
-            lifeImplementation.nextGeneration();
-            int crc = 0;
-            backgroundLayer->fillScreen(colors[0]);
+            deadline += speed;
+            if ((long)(deadline - millis()) >= 0) {
+                waitUntil(deadline);
+            } else {
+                // Late, so show this frame now and start the schedule again from here
+                missedFrames++;
+                deadline = millis();
+            }
 
             if (speedDivisor > 0 && l % speedDivisor == 0) {
                 xMin += speedX;
                 yMin += speedY;
             }
 
-            lifeImplementation.iterateLive([this, &crc, &xMin, &yMin](int x, int y, int on) {
-                if (x >= xMin && x-xMin < xViewportSize && y >= yMin && y-yMin < yViewportSize) {
-                    backgroundLayer->drawPixel(x-xMin, y-yMin, colors[on]);
-                    for (byte tempI = 8; tempI; tempI--) {
-                        byte sum = (crc ^ on) & 0x01;
-                        crc >>= 1;
-                        if (sum) {
-                            crc ^= 0x8C;
-                        }
-                        on >>= 1;
-                    }
-                }
-            });
-            backgroundLayer->swapBuffers(true);
+            draw(xMin, yMin);
+            swapBuffers();
+            frames++;
+            uint64_t hash = lifeImplementation.getHash();
+            nextGeneration();
+            TELEMETRY_FRAME(population());
 
-            if (l % 12 == 0) {
-                if (crc == lastcrc) {
-                    looksDead++;
-                } else {
-                    looksDead = 0;
+            int statePeriod = stateCycles.add(hash);
+            int windowPeriod = speedDivisor == 0 ? windowCycles.add(shownHash()) : 0;
+            if (statePeriod || windowPeriod) {
+                if (cycleStart < 0) {
+                    cycleStart = l;
+                    period = statePeriod ? statePeriod : windowPeriod;
+                    cyclePopulation = population();
+                }
+                if (l - cycleStart >= cycleHold) {
+                    if (statePeriod || population() <= cyclePopulation) break;
+                    cycleStart = -1;
                 }
-                if (looksDead > 10) break;
-                lastcrc = crc;
+            } else {
+                cycleStart = -1;
             }
         }
+        if (cycleStart >= 0) {
+            Serial.printf("Period %d from generation %d\n", period, cycleStart - period);
+        }
+        if (missedFrames > 0) {
+            Serial.printf("%d of %d frames missed the %d ms deadline\n", missedFrames, frames, speed);
+        }
+        TELEMETRY_REPORT();
     }
 
     virtual void setViewport(int x, int y, int width, int height) {
@@ -80,6 +115,7 @@ class LEDMatrixLife {
         yViewportMin = y;
         xViewportSize = width;
         yViewportSize = height;
+        allocateFrames();
     }
 
     virtual void setViewportSpeed(int x, int y, int divisor) {
@@ -91,16 +127,150 @@ class LEDMatrixLife {
     virtual void setColorMap(int nColors, const rgb24 *colors) {
         this->nColors = nColors;
         this->colors = colors;
+        shownValid = false;
     }
 
     virtual void setInitialDelay(int initialDelay) {
         this->initialDelay = initialDelay;
     }
 
+    // Generations to keep showing a pattern once it starts repeating
+    virtual void setCycleHold(int generations) {
+        cycleHold = generations;
+    }
+
+    // Frame period in ms
+    virtual void setSpeed(int speed) {
+        this->speed = speed;
+    }
+
+    // Work to do in the time between frames, such as SoupScout::work. task is
+    // called with the millis() it should return by, leaving idleMargin ms for
+    // the wait to end on time.
+    virtual void setIdleTask(std::function<void(unsigned long deadline)> task) {
+        idleTask = task;
+    }
+
+    // Frames in the last run that were shown late
+    int getMissedFrames() {
+        return missedFrames;
+    }
+
    private:
+    void nextGeneration() {
+        TELEMETRY_TIME(TelemetryGenerate);
+        lifeImplementation.nextGeneration();
+    }
+
+    // Wait for millis() to reach until, giving what time there is to the idle task
+    void waitUntil(unsigned long until) {
+        if (idleTask && (long)(until - millis()) > idleMargin) idleTask(until - idleMargin);
+        long wait = (long)(until - millis());
+        if (wait > 0) delay(wait);
+    }
+
+    void swapBuffers() {
+        TELEMETRY_TIME(TelemetrySwap);
+        backgroundLayer->swapBuffers(true);
+    }
+
+    // Draw the current generation with (xMin, yMin) at the top left. The back
+    // buffer still holds the last frame (swapBuffers copies it), so only pixels
+    // that differ from it are drawn.
+    void draw(int xMin, int yMin) {
+        bool moved = xMin != shownX || yMin != shownY;
+        if (shownValid && !moved && drawChanged(xMin, yMin)) return;
+        // Work out the whole visible frame, then compare it to what is shown
+        int size = xViewportSize * yViewportSize;
+        {
+            TELEMETRY_TIME(TelemetryIterate);
+            memset(frame, 0, size);
+            lifeImplementation.forEachLive([this, xMin, yMin](int x, int y, int on) {
+                if (x >= xMin && x-xMin < xViewportSize && y >= yMin && y-yMin < yViewportSize) {
+                    frame[(y-yMin) * xViewportSize + x-xMin] = on;
+                }
+            });
+        }
+        TELEMETRY_TIME(TelemetryDraw);
+        if (!shownValid) {
+            backgroundLayer->fillScreen(colors[0]);
+            memset(shown, 0, size);
+        }
+        rgb24 *buffer = backgroundLayer->backBuffer();
+        bool direct = xViewportSize <= matrixWidth;
+        for (int y = 0; y < yViewportSize; y++) {
+            byte *row = frame + y * xViewportSize;
+            byte *shownRow = shown + y * xViewportSize;
+            int changed = 0;
+            for (int x = 0; x < xViewportSize; x++) changed += row[x] != shownRow[x];
+            if (changed == 0) continue;
+            TELEMETRY_COUNT(changed);
+            if (direct && changed > maxPixelsPerRow) {
+                rgb24 *out = buffer + y * matrixWidth;
+                for (int x = 0; x < xViewportSize; x++) out[x] = colors[row[x]];
+            } else {
+                for (int x = 0; x < xViewportSize; x++) {
+                    if (row[x] != shownRow[x]) backgroundLayer->drawPixel(x, y, colors[row[x]]);
+                }
+            }
+            memcpy(shownRow, row, xViewportSize);
+        }
+        shownX = xMin;
+        shownY = yMin;
+        shownValid = true;
+    }
+
+    // Draw only the cells the engine reports as changed, if it can
+    bool drawChanged(int xMin, int yMin) {
+        TELEMETRY_TIME(TelemetryChanges);
+        return lifeImplementation.iterateChanged([this, xMin, yMin](int x, int y, int on) {
+            if (x >= xMin && x-xMin < xViewportSize && y >= yMin && y-yMin < yViewportSize) {
+                byte &pixel = shown[(y-yMin) * xViewportSize + x-xMin];
+                if (pixel != on) {
+                    pixel = on;
+                    backgroundLayer->drawPixel(x-xMin, y-yMin, colors[on]);
+                    TELEMETRY_COUNT(1);
+                }
+            }
+        });
+    }
+
+    long population() {
+        long n = 0;
+        lifeImplementation.forEachLive([&n](int, int, int) {
+            n++;
+        });
+        return n;
+    }
+
+    // Hash of the visible cells
+    uint64_t shownHash() {
+        uint64_t hash = 0;
+        for (int y = 0; y < yViewportSize; y++) {
+            const byte *row = shown + y * xViewportSize;
+            for (int x = 0; x < xViewportSize; x++) {
+                if (row[x]) hash += Life::cellHash(x, y, row[x]);
+            }
+        }
+        return hash;
+    }
+
+    void allocateFrames() {
+        int size = xViewportSize * yViewportSize;
+        shown = (byte *)realloc(shown, size);
+        frame = (byte *)realloc(frame, size);
+        shownValid = false;
+    }
+
     Life &lifeImplementation;
     int initialDelay = 0;
     int speed = 20;
+    int missedFrames = 0;
+    int cycleHold = 120;
+    std::function<void(unsigned long deadline)> idleTask;
+    const static int idleMargin = 2;
+    CycleDetector stateCycles;
+    CycleDetector windowCycles;
     int xViewportMin = 0;
     int yViewportMin = 0;
     int xViewportSize = 64;
@@ -109,6 +279,15 @@ class LEDMatrixLife {
     int speedY = 0;
     int speedDivisor = 0;
     SMLayerBackground<rgb24, 0U> *backgroundLayer;
+    int matrixWidth;
+    // Rows with more changes than this are written straight to the buffer
+    const static int maxPixelsPerRow = 8;
+    // States of the pixels in the back buffer, and scratch for a whole frame
+    byte *shown = 0;
+    byte *frame = 0;
+    bool shownValid = false;
+    int shownX = 0;
+    int shownY = 0;
     int nColors;
     const rgb24 *colors;
 };
@@ -1,9 +1,15 @@
 #ifndef Life_h
 #define Life_h
 
+#include "Platform.h"
+
 #include <assert.h>
 #include <climits>
 #include <functional>
+#include <type_traits>
+
+#include "Random.h"
+#include "ThreadPool.h"
 
 // https://conwaylife.com/wiki/Colourised_Life
 
@@ -21,13 +27,11 @@ private:
 
 class Quadlife : public Colorizer {
 public:
+  const static int colors = 4;
   Quadlife()
-    : Colorizer(4){};
-private:
-  int colorIndexForNewLife(int* neighborIndexes) {
-    int count[4];
-    memset(count, 0, sizeof(count));
-
+    : Colorizer(colors){};
+  static constexpr int newColorIndex(const int* neighborIndexes) {
+    int count[4] = {};
     for (int i = 0; i < 3; i++) {
       int index = neighborIndexes[i];
       if (++count[index] > 1) return index;
@@ -38,18 +42,20 @@ private:
     // Logically, we can't get here, but the compiler does not know that
     return 0;
   }
+private:
+  int colorIndexForNewLife(int* neighborIndexes) {
+    return newColorIndex(neighborIndexes);
+  }
 };
 
 class Niemieclife : public Colorizer {
 public:
+  const static int colors = 8;
   Niemieclife()
-    : Colorizer(8){};
-private:
-  int colorIndexForNewLife(int* neighborIndexes) {
-    int count[8];
-    int set[2];
-    memset(count, 0, sizeof(count));
-    memset(set, 0, sizeof(set));
+    : Colorizer(colors){};
+  static constexpr int newColorIndex(const int* neighborIndexes) {
+    int count[8] = {};
+    int set[2] = {};
     //Three cells of the same colour produce a child of the same colour (x+x+x→x)
     //Two cells of any one colour plus one of any colour favour the dominant colour (x+x+y→x)
     for (int i = 0; i < 3; i++) {
@@ -86,465 +92,838 @@ private:
     // Logically, we can't get here, but the compiler does not know that
     return 0;
   }
+private:
+  int colorIndexForNewLife(int* neighborIndexes) {
+    return newColorIndex(neighborIndexes);
+  }
+};
+
+// Rule that depends only on a cell's own state and how many of its neighbors
+// are live (see CountRule)
+struct CountTable {
+  // next holds this where the new state is picked by the rule, as for a birth
+  // in Colourised Life
+  const static byte choose = 255;
+  // 1 if a neighbor in this state counts as live
+  byte live[256];
+  // New state from the cell's state and its live neighbor count
+  byte next[256][9];
 };
 
 class TreeRule {
 public:
+  virtual ~TreeRule() {}
   virtual int transition(int* neighbors) = 0;
+  // Rules backed by a rule tree expose it so that it can be compiled into flat
+  // tables (see CompiledRule). Starting from the root, each neighbor in turn
+  // selects the next node, and the last step gives the new state.
+  virtual int getTreeRoot() {
+    return -1;
+  }
+  virtual int getTreeNode(int /*node*/, int /*state*/) {
+    return 0;
+  }
+  virtual const CountTable* getCountTable() {
+    return 0;
+  }
 };
 
-class GenerationsTreeRule : public TreeRule {
+// Rule trees generated at compile time. A rule is described by a Summary
+// class, giving the number of states, a summary of the neighbors seen so far as
+// a code from 0 to nCodes - 1, how the code changes with each neighbor's state,
+// and the new state given the final code and the cell's own state:
+//
+//   struct Summary {
+//     static constexpr int nStates;
+//     static constexpr int nCodes;
+//     static constexpr int add(int code, int state);
+//     static constexpr int result(int code, int center);
+//   };
+//
+// The tree has one node for each code reachable at each depth, with identical
+// nodes merged, and the root last. The table is a static constexpr, so all
+// instances share one copy, and it uses the narrowest type that holds the node
+// numbers.
+template <class Summary>
+struct RuleTree {
+  const static int nStates = Summary::nStates;
+  const static int maxNodes = 1024;
+
+  struct Nodes {
+    int lookup[maxNodes][nStates];
+    int count;
+  };
+  static constexpr Nodes build() {
+    Nodes nodes = {};
+    // Codes reachable after each number of neighbors
+    bool reachable[10][Summary::nCodes] = {};
+    reachable[0][0] = true;
+    for (int depth = 0; depth < 8; depth++) {
+      for (int code = 0; code < Summary::nCodes; code++) {
+        if (!reachable[depth][code]) continue;
+        for (int s = 0; s < nStates; s++) reachable[depth + 1][Summary::add(code, s)] = true;
+      }
+    }
+    // Build from the center up, so every node follows its children
+    int nodeOf[10][Summary::nCodes] = {};
+    for (int depth = 8; depth >= 0; depth--) {
+      for (int code = 0; code < Summary::nCodes; code++) {
+        if (!reachable[depth][code]) continue;
+        int children[nStates] = {};
+        for (int s = 0; s < nStates; s++) {
+          children[s] = depth == 8 ? Summary::result(code, s) : nodeOf[depth + 1][Summary::add(code, s)];
+        }
+        int node = 0;
+        for (; node < nodes.count && node < maxNodes; node++) {
+          bool same = true;
+          for (int s = 0; s < nStates && same; s++) same = nodes.lookup[node][s] == children[s];
+          if (same) break;
+        }
+        if (node == nodes.count || node == maxNodes) {
+          node = nodes.count;
+          if (node < maxNodes) {
+            for (int s = 0; s < nStates; s++) nodes.lookup[node][s] = children[s];
+          }
+          nodes.count++;
+        }
+        nodeOf[depth][code] = node;
+      }
+    }
+    return nodes;
+  }
+
+  // Built once to count the nodes, then again to fill a table that size
+  const static int nNodes = build().count;
+  static_assert(nNodes <= maxNodes, "Rule tree has too many nodes");
+  typedef typename std::conditional<nNodes <= 256, uint8_t, uint16_t>::type Node;
+  struct Table {
+    Node lookup[nNodes][nStates];
+  };
+  static constexpr Table table() {
+    Nodes nodes = build();
+    Table t = {};
+    for (int node = 0; node < nNodes; node++) {
+      for (int s = 0; s < nStates; s++) t.lookup[node][s] = nodes.lookup[node][s];
+    }
+    return t;
+  }
+  static constexpr Table tree = table();
+};
+// Needed before C++17, where the member isn't implicitly inline
+template <class Summary>
+constexpr typename RuleTree<Summary>::Table RuleTree<Summary>::tree;
+
+template <class Summary>
+class StaticTreeRule : public TreeRule {
 public:
   int transition(int* neighbors) {
-    int node = 37;
+    int node = root;
     int* n = neighbors;
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
+    node = Tree::tree.lookup[node][*(n++)];
     return node;
   }
+  int getTreeRoot() {
+    return root;
+  }
+  int getTreeNode(int node, int state) {
+    return Tree::tree.lookup[node][state];
+  }
 private:
-  const byte lookup[38][8] = {
-    { 0, 2, 3, 4, 5, 6, 7, 0 },
-    { 0, 1, 3, 4, 5, 6, 7, 0 },
-    { 0, 1, 0, 0, 0, 0, 0, 0 },
-    { 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 2, 3, 2, 2, 2, 2, 2, 2 },
-    { 3, 3, 3, 3, 3, 3, 3, 3 },
-    { 4, 5, 4, 4, 4, 4, 4, 4 },
-    { 1, 1, 3, 4, 5, 6, 7, 0 },
-    { 1, 7, 1, 1, 1, 1, 1, 1 },
-    { 3, 8, 3, 3, 3, 3, 3, 3 },
-    { 5, 9, 5, 5, 5, 5, 5, 5 },
-    { 6, 10, 6, 6, 6, 6, 6, 6 },
-    { 7, 7, 7, 7, 7, 7, 7, 7 },
-    { 8, 12, 8, 8, 8, 8, 8, 8 },
-    { 9, 13, 9, 9, 9, 9, 9, 9 },
-    { 10, 14, 10, 10, 10, 10, 10, 10 },
-    { 11, 15, 11, 11, 11, 11, 11, 11 },
-    { 1, 2, 3, 4, 5, 6, 7, 0 },
-    { 7, 17, 7, 7, 7, 7, 7, 7 },
-    { 12, 18, 12, 12, 12, 12, 12, 12 },
-    { 13, 19, 13, 13, 13, 13, 13, 13 },
-    { 14, 20, 14, 14, 14, 14, 14, 14 },
-    { 15, 21, 15, 15, 15, 15, 15, 15 },
-    { 16, 22, 16, 16, 16, 16, 16, 16 },
-    { 17, 17, 17, 17, 17, 17, 17, 17 },
-    { 18, 24, 18, 18, 18, 18, 18, 18 },
-    { 19, 25, 19, 19, 19, 19, 19, 19 },
-    { 20, 26, 20, 20, 20, 20, 20, 20 },
-    { 21, 27, 21, 21, 21, 21, 21, 21 },
-    { 22, 28, 22, 22, 22, 22, 22, 22 },
-    { 23, 29, 23, 23, 23, 23, 23, 23 },
-    { 24, 24, 24, 24, 24, 24, 24, 24 },
-    { 25, 31, 25, 25, 25, 25, 25, 25 },
-    { 26, 32, 26, 26, 26, 26, 26, 26 },
-    { 27, 33, 27, 27, 27, 27, 27, 27 },
-    { 28, 34, 28, 28, 28, 28, 28, 28 },
-    { 29, 35, 29, 29, 29, 29, 29, 29 },
-    { 30, 36, 30, 30, 30, 30, 30, 30 }
-  };
+  typedef RuleTree<Summary> Tree;
+  const static int root = Tree::nNodes - 1;
 };
 
-class Generations1TreeRule : public TreeRule {
-  public:
-    int transition(int* neighbors) {
-      int node = 35;
-      int* n = neighbors;
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      node = lookup[node][*(n++)];
-      return node;
+// Digits of a rule string such as "23" as a mask
+constexpr int ruleMask(const char* digits) {
+  int mask = 0;
+  for (; *digits; digits++) mask |= 1 << (*digits - '0');
+  return mask;
+}
+
+// Generations rules, S/B/C: cells in state 1 are live, and those that don't
+// survive go through states 2 to nStates - 1 before dying. The code is the
+// number of live neighbors.
+template <int survive, int birth, int states>
+struct GenerationsSummary {
+  const static int nStates = states;
+  const static int nCodes = 9;
+  static constexpr int add(int code, int state) {
+    return code + (state == 1);
+  }
+  static constexpr int result(int code, int center) {
+    if (center == 0) return (birth >> code) & 1;
+    if (center == 1) return (survive >> code) & 1 ? 1 : (nStates > 2 ? 2 : 0);
+    return (center + 1) % nStates;
+  }
+};
 
+// Colourised Life: states 1 to C::colors are live cells of each colour, and a
+// birth takes the colour C picks for its three parents. The code holds the
+// colours of up to three live neighbors as base 9 digits, or maxCode for more
+// than three.
+template <class C, int survive, int birth>
+struct ColourisedSummary {
+  const static int nStates = C::colors + 1;
+  const static int maxCode = 9 * 9 * 9;
+  const static int nCodes = maxCode + 1;
+  static constexpr int count(int code) {
+    return code == maxCode ? 4 : (code >= 81) + (code >= 9) + (code >= 1);
+  }
+  static constexpr int add(int code, int state) {
+    if (state == 0) return code;
+    if (count(code) >= 3) return maxCode;
+    // The colours fill the lowest digits, smallest first
+    int colors[3] = { code / 81, code / 9 % 9, code % 9 };
+    int n = count(code);
+    int i = 3 - n - 1;
+    colors[i] = state;
+    for (; i < 2 && colors[i] > colors[i + 1]; i++) {
+      int t = colors[i];
+      colors[i] = colors[i + 1];
+      colors[i + 1] = t;
     }
-  private:
-    const byte lookup[36][4] = {
-      {0,2,3,0},
-      {0,0,0,0},
-      {1,2,3,0},
-      {0,2,0,0},
-      {1,3,1,1},
-      {0,1,3,0},
-      {2,5,2,2},
-      {3,6,3,3},
-      {4,7,4,4},
-      {5,5,5,5},
-      {6,9,6,6},
-      {7,10,7,7},
-      {8,11,8,8},
-      {9,9,9,9},
-      {10,13,10,10},
-      {11,14,11,11},
-      {12,15,12,12},
-      {5,0,5,5},
-      {9,17,9,9},
-      {13,18,13,13},
-      {14,19,14,14},
-      {15,20,15,15},
-      {16,21,16,16},
-      {17,1,17,17},
-      {18,23,18,18},
-      {19,24,19,19},
-      {20,25,20,20},
-      {21,26,21,21},
-      {22,27,22,22},
-      {1,1,1,1},
-      {23,29,23,23},
-      {24,30,24,24},
-      {25,31,25,25},
-      {26,32,26,26},
-      {27,33,27,27},
-      {28,34,28,28}
-    };
+    return colors[0] * 81 + colors[1] * 9 + colors[2];
+  }
+  static constexpr int result(int code, int center) {
+    int n = count(code);
+    if (center) return (survive >> n) & 1 ? center : 0;
+    // Only births from three parents are supported
+    if (n != 3 || !((birth >> n) & 1)) return 0;
+    int indexes[3] = { code / 81 - 1, code / 9 % 9 - 1, code % 9 - 1 };
+    return C::newColorIndex(indexes) + 1;
+  }
 };
 
-class NiemiecTreeRule : public TreeRule {
+// 12345/45678/8
+class GenerationsTreeRule : public StaticTreeRule<GenerationsSummary<ruleMask("12345"), ruleMask("45678"), 8>> {};
+
+// 345/2/4
+class Generations1TreeRule : public StaticTreeRule<GenerationsSummary<ruleMask("345"), ruleMask("2"), 4>> {};
+
+// B3/S23 with Niemiec's colours
+class NiemiecTreeRule : public StaticTreeRule<ColourisedSummary<Niemieclife, ruleMask("23"), ruleMask("3")>> {};
+
+// Rule built at runtime from a rule string, evaluated from a table indexed by the
+// cell's state and its live neighbor count rather than a rule tree. Accepts
+//   B3/S23 or S23/B3     Life-like, letters in either case
+//   23/3                 S/B
+//   12345/45678/8        Generations S/B/C, also as B45678/S12345/C8
+// Given a Colorizer, live cells are states 1 to nColors, and a cell born with
+// exactly three live neighbors takes the colour the Colorizer picks for them
+// (see Colourised Life). Births with other counts take the most common colour.
+//
+//   CountRule rule(new Niemieclife());
+//   if (rule.parse("B3/S23")) life.setRule(rule.getNStates(), &rule);
+class CountRule : public TreeRule {
 public:
+  CountRule(Colorizer* colorizer = 0)
+    : colorizer(colorizer) {}
+  // Returns false, leaving the rule unchanged, if the string is not understood
+  bool parse(const char* rule) {
+    int masks[2] = { 0, 0 };  // Survival, birth
+    int nGenerations = 2;
+    int field = 0;
+    const char* c = rule;
+    while (*c == ' ') c++;
+    for (; field < 3; field++) {
+      int kind = field;
+      if (*c == 'S' || *c == 's') {
+        kind = 0;
+        c++;
+      } else if (*c == 'B' || *c == 'b') {
+        kind = 1;
+        c++;
+      } else if (*c == 'C' || *c == 'c' || *c == 'G' || *c == 'g') {
+        kind = 2;
+        c++;
+      }
+      if (kind == 2) {
+        if (*c < '0' || *c > '9') return false;
+        nGenerations = 0;
+        while (*c >= '0' && *c <= '9') nGenerations = nGenerations * 10 + *c++ - '0';
+      } else {
+        while (*c >= '0' && *c <= '8') masks[kind] |= 1 << (*c++ - '0');
+      }
+      if (*c != '/') break;
+      c++;
+    }
+    while (*c == ' ') c++;
+    if (*c || field == 0) return false;
+    // An empty neighborhood must stay empty
+    if (masks[1] & 1) return false;
+    if (nGenerations < 2 || nGenerations > 255) return false;
+    if (colorizer && nGenerations > 2) return false;
+    build(masks[0], masks[1], nGenerations);
+    return true;
+  }
+  int getNStates() {
+    return nStates;
+  }
   int transition(int* neighbors) {
-    int node = 271;
-    int* n = neighbors;
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
-    node = lookup[node][*(n++)];
+    int count = 0;
+    for (int i = 0; i < 8; i++) count += table.live[neighbors[i]];
+    int next = table.next[neighbors[8]][count];
+    return next == CountTable::choose ? colorize(neighbors, count) : next;
+  }
+  const CountTable* getCountTable() {
+    return &table;
+  }
+private:
+  void build(int survive, int birth, int nGenerations) {
+    nStates = colorizer ? colorizer->getNColors() + 1 : nGenerations;
+    memset(&table, 0, sizeof(table));
+    for (int state = 1; state < nStates; state++) {
+      table.live[state] = colorizer || state == 1;
+    }
+    int dying = nGenerations > 2 ? 2 : 0;
+    for (int count = 0; count <= 8; count++) {
+      if (birth & (1 << count)) table.next[0][count] = colorizer ? CountTable::choose : 1;
+      for (int state = 1; state < nStates; state++) {
+        if (table.live[state]) {
+          table.next[state][count] = survive & (1 << count) ? state : dying;
+        } else {
+          table.next[state][count] = (state + 1) % nGenerations;
+        }
+      }
+    }
+  }
+  int colorize(int* neighbors, int count) {
+    int indexes[8];
+    int n = 0;
+    for (int i = 0; i < 8; i++) {
+      if (neighbors[i]) indexes[n++] = neighbors[i] - 1;
+    }
+    if (count == 3) return colorizer->colorIndexForNewLife(indexes) + 1;
+    int best = 0, bestCount = 0;
+    for (int i = 0; i < n; i++) {
+      int same = 0;
+      for (int j = 0; j < n; j++) same += indexes[j] == indexes[i];
+      if (same > bestCount || (same == bestCount && indexes[i] < best)) {
+        best = indexes[i];
+        bestCount = same;
+      }
+    }
+    return best + 1;
+  }
+  Colorizer* colorizer;
+  int nStates = 2;
+  CountTable table = {};
+};
+
+// Flattened form of a TreeRule, so engines can evaluate the rule without a
+// virtual call and nine dependent loads per cell.
+//
+// When nStates^9 is small enough the whole rule becomes one directly indexed
+// table. Otherwise the tree is partially evaluated a row at a time: the top
+// row of three neighbors selects a node, which together with the two side
+// neighbors selects a second node, then the bottom row and finally the center
+// cell give the new state. Nodes are renumbered densely at each stage, so the
+// tables stay small (about 33KB for NiemiecTreeRule).
+//
+// Rules that don't expose their tree are enumerated into a direct table when
+// that is small enough. Count based rules too large for that are evaluated
+// from their CountTable, otherwise we fall back to calling the rule.
+//
+// Count based rules can also be evaluated from how many cells of each live
+// state are in the 3x3 window, four bits per state, which engines can keep up
+// to date as they slide along a row instead of loading all nine cells (see
+// getCountWeights).
+class CompiledRule {
+public:
+  CompiledRule() {}
+  CompiledRule(const CompiledRule&) = delete;
+  ~CompiledRule() {
+    release();
+  }
+  // If nStates is not known (<= 0) the rule is just called
+  void compile(int nStates, TreeRule* rule, long maxDirect = 1 << 16) {
+    release();
+    this->nStates = nStates;
+    this->rule = rule;
+    if (nStates <= 0) return;
+    long directSize = 1;
+    for (int i = 0; i < 9; i++) {
+      directSize *= nStates;
+      if (directSize > maxDirect) break;
+    }
+    int root = rule->getTreeRoot();
+    if (directSize <= maxDirect) {
+      direct = (byte*)malloc(directSize);
+      int neighbors[9];
+      for (long index = 0; index < directSize; index++) {
+        long i = index;
+        for (int j = 8; j >= 0; j--) {
+          neighbors[j] = i % nStates;
+          i /= nStates;
+        }
+        direct[index] = root >= 0 ? walk(root, neighbors, 9) : rule->transition(neighbors);
+      }
+    } else if (rule->getCountTable()) {
+      count = rule->getCountTable();
+      buildCountWeights();
+    } else if (root >= 0) {
+      // Stages consume neighbors 0-2, 3-4, 5-7 and 8
+      int nodes[maxNodes];
+      int nNodes = 1;
+      nodes[0] = root;
+      nNodes = buildStage(top, nodes, nNodes, 3);
+      if (nNodes > 0) nNodes = buildStage(middle, nodes, nNodes, 2);
+      if (nNodes > 0) nNodes = buildStage(bottom, nodes, nNodes, 3);
+      if (nNodes > 0) buildStage(center, nodes, nNodes, 1, false);
+      // Too many distinct nodes at some stage, so just call the rule
+      if (nNodes < 0) release();
+    }
+  }
+  int transition(int* n) {
+    const int s = nStates;
+    if (direct) {
+      return direct[(((((((n[0] * s + n[1]) * s + n[2]) * s + n[3]) * s + n[4]) * s + n[5]) * s + n[6]) * s + n[7]) * s + n[8]];
+    } else if (top) {
+      int node = top[(n[0] * s + n[1]) * s + n[2]];
+      node = middle[(node * s + n[3]) * s + n[4]];
+      node = bottom[((node * s + n[5]) * s + n[6]) * s + n[7]];
+      return center[node * s + n[8]];
+    } else if (count) {
+      const byte* live = count->live;
+      int next = count->next[n[8]][live[n[0]] + live[n[1]] + live[n[2]] + live[n[3]] + live[n[4]] + live[n[5]] + live[n[6]] + live[n[7]]];
+      return next == CountTable::choose ? rule->transition(n) : next;
+    } else {
+      return rule->transition(n);
+    }
+  }
+  // The window counts are the sum of the weights of the nine cells, or 0 if the
+  // rule can't be evaluated from them
+  const uint32_t* getCountWeights() {
+    return weights;
+  }
+  // New state of center, given the counts of its 3x3 window
+  int transition(int center, uint32_t counts) {
+    counts -= weights[center];
+    // Add up the four bit fields into the top one
+    int live = (counts * 0x11111111u) >> 28;
+    int next = count->next[center][live];
+    return next == CountTable::choose ? choose(center, counts, live) : next;
+  }
+private:
+  static const int maxNodes = 1024;
+  // States that have a four bit field in the window counts
+  static const int maxCountedStates = 8;
+
+  int walk(int node, int* neighbors, int n) {
+    for (int i = 0; i < n; i++) {
+      node = rule->getTreeNode(node, neighbors[i]);
+    }
     return node;
   }
+  // Fill table with the result of walking depth more levels from each of nodes.
+  // Unless this is the last stage, the results are renumbered and replace nodes.
+  // Returns -1 if there are more than maxNodes of them.
+  int buildStage(unsigned short*& table, int* nodes, int nNodes, int depth, bool renumber = true) {
+    int perNode = 1;
+    for (int i = 0; i < depth; i++) perNode *= nStates;
+    table = (unsigned short*)malloc(sizeof(unsigned short) * nNodes * perNode);
+    int found[maxNodes];
+    int nFound = 0;
+    int neighbors[3];
+    for (int n = 0; n < nNodes; n++) {
+      for (int key = 0; key < perNode; key++) {
+        int k = key;
+        for (int j = depth - 1; j >= 0; j--) {
+          neighbors[j] = k % nStates;
+          k /= nStates;
+        }
+        int next = walk(nodes[n], neighbors, depth);
+        if (renumber) {
+          int id = 0;
+          while (id < nFound && found[id] != next) id++;
+          if (id == nFound) {
+            if (nFound == maxNodes) return -1;
+            found[nFound++] = next;
+          }
+          next = id;
+        }
+        table[n * perNode + key] = next;
+      }
+    }
+    memcpy(nodes, found, sizeof(int) * nFound);
+    return nFound;
+  }
+  // Count based rules qualify if only states 1 to maxCountedStates are live
+  void buildCountWeights() {
+    for (int state = maxCountedStates + 1; state < nStates; state++) {
+      if (count->live[state]) return;
+    }
+    weights = (uint32_t*)calloc(nStates, sizeof(uint32_t));
+    for (int state = 1; state < nStates && state <= maxCountedStates; state++) {
+      if (count->live[state]) weights[state] = 1u << (4 * (state - 1));
+    }
+    // The state born to each set of three live neighbors, smallest state first
+    if (count->next[0][3] == CountTable::choose) {
+      born = (byte*)malloc(maxCountedStates * maxCountedStates * maxCountedStates);
+      int neighbors[9] = {};
+      for (int i = 0; i < maxCountedStates * maxCountedStates * maxCountedStates; i++) {
+        neighbors[0] = i / (maxCountedStates * maxCountedStates) + 1;
+        neighbors[1] = i / maxCountedStates % maxCountedStates + 1;
+        neighbors[2] = i % maxCountedStates + 1;
+        bool valid = neighbors[0] <= neighbors[1] && neighbors[1] <= neighbors[2] && neighbors[2] < nStates;
+        born[i] = valid ? rule->transition(neighbors) : 0;
+      }
+    }
+  }
+  // A count based rule gives the same result wherever the neighbors are, so
+  // lay them out in order of state and ask the rule
+  int choose(int center, uint32_t counts, int live) {
+    int neighbors[9] = {};
+    int n = 0;
+    for (int state = 1; counts; state++, counts >>= 4) {
+      for (int i = counts & 15; i > 0; i--) neighbors[n++] = state;
+    }
+    if (born && center == 0 && live == 3) {
+      return born[((neighbors[0] - 1) * maxCountedStates + neighbors[1] - 1) * maxCountedStates + neighbors[2] - 1];
+    }
+    neighbors[8] = center;
+    return rule->transition(neighbors);
+  }
+  void release() {
+    free(direct);
+    free(top);
+    free(middle);
+    free(bottom);
+    free(center);
+    free(weights);
+    free(born);
+    direct = 0;
+    top = middle = bottom = center = 0;
+    count = 0;
+    weights = 0;
+    born = 0;
+  }
+  int nStates = 0;
+  TreeRule* rule = 0;
+  byte* direct = 0;
+  unsigned short* top = 0;
+  unsigned short* middle = 0;
+  unsigned short* bottom = 0;
+  unsigned short* center = 0;
+  const CountTable* count = 0;
+  uint32_t* weights = 0;
+  byte* born = 0;
+};
+
+// Remembers the hashes of recent generations to spot when a state repeats
+class CycleDetector {
+public:
+  void clear() {
+    count = 0;
+  }
+  // Returns the period if hash matches one of the last maxPeriod hashes, else 0
+  int add(uint64_t hash) {
+    int period = 0;
+    int n = min(count, (int)maxPeriod);
+    for (int p = 1; p <= n; p++) {
+      if (hashes[(count - p) % maxPeriod] == hash) {
+        period = p;
+        break;
+      }
+    }
+    hashes[count % maxPeriod] = hash;
+    count++;
+    return period;
+  }
 private:
-  const short lookup[272][9] = {
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 0, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 0, 2, 2, 2, 2, 2, 2, 2, 2 },
-    { 1, 3, 3, 3, 3, 3, 3, 3, 3 },
-    { 1, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 2, 5, 5, 5, 5, 5, 5, 5, 5 },
-    { 2, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 8, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 7, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 2, 5, 7, 8, 9, 7, 5, 9, 8 },
-    { 3, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 6, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 2, 5, 8, 11, 12, 11, 12, 5, 8 },
-    { 4, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 2, 5, 9, 12, 14, 14, 12, 9, 5 },
-    { 5, 1, 2, 3, 4, 5, 6, 7, 8 },
-    { 2, 5, 7, 11, 14, 16, 12, 9, 8 },
-    { 2, 5, 5, 12, 12, 12, 12, 5, 5 },
-    { 2, 5, 9, 5, 9, 9, 5, 9, 5 },
-    { 2, 5, 8, 8, 5, 8, 5, 5, 8 },
-    { 3, 6, 10, 13, 15, 17, 18, 19, 20 },
-    { 2, 7, 7, 7, 7, 7, 7, 7, 7 },
-    { 2, 8, 7, 11, 16, 16, 11, 7, 8 },
-    { 2, 9, 7, 16, 14, 16, 14, 9, 7 },
-    { 2, 7, 7, 16, 16, 16, 16, 7, 7 },
-    { 2, 9, 7, 7, 9, 7, 9, 9, 7 },
-    { 2, 8, 7, 8, 7, 7, 8, 7, 8 },
-    { 3, 10, 22, 23, 24, 25, 17, 26, 27 },
-    { 2, 11, 11, 11, 11, 11, 11, 11, 11 },
-    { 2, 12, 16, 11, 14, 16, 12, 14, 11 },
-    { 2, 11, 16, 11, 16, 16, 11, 16, 11 },
-    { 2, 12, 11, 11, 12, 11, 12, 12, 11 },
-    { 2, 8, 8, 11, 11, 11, 11, 8, 8 },
-    { 3, 13, 23, 29, 30, 31, 32, 17, 33 },
-    { 2, 14, 14, 14, 14, 14, 14, 14, 14 },
-    { 2, 14, 16, 16, 14, 16, 14, 14, 16 },
-    { 2, 12, 14, 12, 14, 14, 12, 14, 12 },
-    { 2, 9, 9, 14, 14, 14, 14, 9, 9 },
-    { 3, 15, 24, 30, 35, 36, 37, 38, 17 },
-    { 2, 16, 16, 16, 16, 16, 16, 16, 16 },
-    { 3, 17, 25, 31, 36, 40, 30, 24, 23 },
-    { 2, 12, 12, 12, 12, 12, 12, 12, 12 },
-    { 3, 18, 17, 32, 37, 30, 42, 15, 13 },
-    { 2, 9, 9, 9, 9, 9, 9, 9, 9 },
-    { 3, 19, 26, 17, 38, 24, 15, 44, 10 },
-    { 2, 8, 8, 8, 8, 8, 8, 8, 8 },
-    { 3, 20, 27, 33, 17, 23, 13, 10, 46 },
-    { 4, 21, 28, 34, 39, 41, 43, 45, 47 },
-    { 5, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 6, 49, 49, 49, 49, 49, 49, 49, 49 },
-    { 7, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 8, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 9, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 10, 49, 51, 52, 53, 51, 49, 53, 52 },
-    { 11, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 12, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 13, 49, 52, 55, 56, 55, 56, 49, 52 },
-    { 14, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 15, 49, 53, 56, 58, 58, 56, 53, 49 },
-    { 16, 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 17, 49, 51, 55, 58, 60, 56, 53, 52 },
-    { 18, 49, 49, 56, 56, 56, 56, 49, 49 },
-    { 19, 49, 53, 49, 53, 53, 49, 53, 49 },
-    { 20, 49, 52, 52, 49, 52, 49, 49, 52 },
-    { 21, 50, 54, 57, 59, 61, 62, 63, 64 },
-    { 22, 51, 51, 51, 51, 51, 51, 51, 51 },
-    { 23, 52, 51, 55, 60, 60, 55, 51, 52 },
-    { 24, 53, 51, 60, 58, 60, 58, 53, 51 },
-    { 25, 51, 51, 60, 60, 60, 60, 51, 51 },
-    { 26, 53, 51, 51, 53, 51, 53, 53, 51 },
-    { 27, 52, 51, 52, 51, 51, 52, 51, 52 },
-    { 28, 54, 66, 67, 68, 69, 61, 70, 71 },
-    { 29, 55, 55, 55, 55, 55, 55, 55, 55 },
-    { 30, 56, 60, 55, 58, 60, 56, 58, 55 },
-    { 31, 55, 60, 55, 60, 60, 55, 60, 55 },
-    { 32, 56, 55, 55, 56, 55, 56, 56, 55 },
-    { 33, 52, 52, 55, 55, 55, 55, 52, 52 },
-    { 34, 57, 67, 73, 74, 75, 76, 61, 77 },
-    { 35, 58, 58, 58, 58, 58, 58, 58, 58 },
-    { 36, 58, 60, 60, 58, 60, 58, 58, 60 },
-    { 37, 56, 58, 56, 58, 58, 56, 58, 56 },
-    { 38, 53, 53, 58, 58, 58, 58, 53, 53 },
-    { 39, 59, 68, 74, 79, 80, 81, 82, 61 },
-    { 40, 60, 60, 60, 60, 60, 60, 60, 60 },
-    { 41, 61, 69, 75, 80, 84, 74, 68, 67 },
-    { 42, 56, 56, 56, 56, 56, 56, 56, 56 },
-    { 43, 62, 61, 76, 81, 74, 86, 59, 57 },
-    { 44, 53, 53, 53, 53, 53, 53, 53, 53 },
-    { 45, 63, 70, 61, 82, 68, 59, 88, 54 },
-    { 46, 52, 52, 52, 52, 52, 52, 52, 52 },
-    { 47, 64, 71, 77, 61, 67, 57, 54, 90 },
-    { 48, 65, 72, 78, 83, 85, 87, 89, 91 },
-    { 49, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 50, 93, 93, 93, 93, 93, 93, 93, 93 },
-    { 51, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 52, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 53, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 54, 93, 95, 96, 97, 95, 93, 97, 96 },
-    { 55, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 56, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 57, 93, 96, 99, 100, 99, 100, 93, 96 },
-    { 58, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 59, 93, 97, 100, 102, 102, 100, 97, 93 },
-    { 60, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 61, 93, 95, 99, 102, 104, 100, 97, 96 },
-    { 62, 93, 93, 100, 100, 100, 100, 93, 93 },
-    { 63, 93, 97, 93, 97, 97, 93, 97, 93 },
-    { 64, 93, 96, 96, 93, 96, 93, 93, 96 },
-    { 65, 94, 98, 101, 103, 105, 106, 107, 108 },
-    { 66, 95, 95, 95, 95, 95, 95, 95, 95 },
-    { 67, 96, 95, 99, 104, 104, 99, 95, 96 },
-    { 68, 97, 95, 104, 102, 104, 102, 97, 95 },
-    { 69, 95, 95, 104, 104, 104, 104, 95, 95 },
-    { 70, 97, 95, 95, 97, 95, 97, 97, 95 },
-    { 71, 96, 95, 96, 95, 95, 96, 95, 96 },
-    { 72, 98, 110, 111, 112, 113, 105, 114, 115 },
-    { 73, 99, 99, 99, 99, 99, 99, 99, 99 },
-    { 74, 100, 104, 99, 102, 104, 100, 102, 99 },
-    { 75, 99, 104, 99, 104, 104, 99, 104, 99 },
-    { 76, 100, 99, 99, 100, 99, 100, 100, 99 },
-    { 77, 96, 96, 99, 99, 99, 99, 96, 96 },
-    { 78, 101, 111, 117, 118, 119, 120, 105, 121 },
-    { 79, 102, 102, 102, 102, 102, 102, 102, 102 },
-    { 80, 102, 104, 104, 102, 104, 102, 102, 104 },
-    { 81, 100, 102, 100, 102, 102, 100, 102, 100 },
-    { 82, 97, 97, 102, 102, 102, 102, 97, 97 },
-    { 83, 103, 112, 118, 123, 124, 125, 126, 105 },
-    { 84, 104, 104, 104, 104, 104, 104, 104, 104 },
-    { 85, 105, 113, 119, 124, 128, 118, 112, 111 },
-    { 86, 100, 100, 100, 100, 100, 100, 100, 100 },
-    { 87, 106, 105, 120, 125, 118, 130, 103, 101 },
-    { 88, 97, 97, 97, 97, 97, 97, 97, 97 },
-    { 89, 107, 114, 105, 126, 112, 103, 132, 98 },
-    { 90, 96, 96, 96, 96, 96, 96, 96, 96 },
-    { 91, 108, 115, 121, 105, 111, 101, 98, 134 },
-    { 92, 109, 116, 122, 127, 129, 131, 133, 135 },
-    { 1, 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 93, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 94, 138, 138, 138, 138, 138, 138, 138, 138 },
-    { 95, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 96, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 97, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 98, 138, 140, 141, 142, 140, 138, 142, 141 },
-    { 99, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 100, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 101, 138, 141, 144, 145, 144, 145, 138, 141 },
-    { 102, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 103, 138, 142, 145, 147, 147, 145, 142, 138 },
-    { 104, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 105, 138, 140, 144, 147, 149, 145, 142, 141 },
-    { 106, 138, 138, 145, 145, 145, 145, 138, 138 },
-    { 107, 138, 142, 138, 142, 142, 138, 142, 138 },
-    { 108, 138, 141, 141, 138, 141, 138, 138, 141 },
-    { 109, 139, 143, 146, 148, 150, 151, 152, 153 },
-    { 110, 140, 140, 140, 140, 140, 140, 140, 140 },
-    { 111, 141, 140, 144, 149, 149, 144, 140, 141 },
-    { 112, 142, 140, 149, 147, 149, 147, 142, 140 },
-    { 113, 140, 140, 149, 149, 149, 149, 140, 140 },
-    { 114, 142, 140, 140, 142, 140, 142, 142, 140 },
-    { 115, 141, 140, 141, 140, 140, 141, 140, 141 },
-    { 116, 143, 155, 156, 157, 158, 150, 159, 160 },
-    { 117, 144, 144, 144, 144, 144, 144, 144, 144 },
-    { 118, 145, 149, 144, 147, 149, 145, 147, 144 },
-    { 119, 144, 149, 144, 149, 149, 144, 149, 144 },
-    { 120, 145, 144, 144, 145, 144, 145, 145, 144 },
-    { 121, 141, 141, 144, 144, 144, 144, 141, 141 },
-    { 122, 146, 156, 162, 163, 164, 165, 150, 166 },
-    { 123, 147, 147, 147, 147, 147, 147, 147, 147 },
-    { 124, 147, 149, 149, 147, 149, 147, 147, 149 },
-    { 125, 145, 147, 145, 147, 147, 145, 147, 145 },
-    { 126, 142, 142, 147, 147, 147, 147, 142, 142 },
-    { 127, 148, 157, 163, 168, 169, 170, 171, 150 },
-    { 128, 149, 149, 149, 149, 149, 149, 149, 149 },
-    { 129, 150, 158, 164, 169, 173, 163, 157, 156 },
-    { 130, 145, 145, 145, 145, 145, 145, 145, 145 },
-    { 131, 151, 150, 165, 170, 163, 175, 148, 146 },
-    { 132, 142, 142, 142, 142, 142, 142, 142, 142 },
-    { 133, 152, 159, 150, 171, 157, 148, 177, 143 },
-    { 134, 141, 141, 141, 141, 141, 141, 141, 141 },
-    { 135, 153, 160, 166, 150, 156, 146, 143, 179 },
-    { 136, 154, 161, 167, 172, 174, 176, 178, 180 },
-    { 137, 137, 137, 137, 137, 137, 137, 137, 137 },
-    { 138, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 139, 183, 183, 183, 183, 183, 183, 183, 183 },
-    { 140, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 141, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 142, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 143, 183, 185, 186, 187, 185, 183, 187, 186 },
-    { 144, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 145, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 146, 183, 186, 189, 190, 189, 190, 183, 186 },
-    { 147, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 148, 183, 187, 190, 192, 192, 190, 187, 183 },
-    { 149, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 150, 183, 185, 189, 192, 194, 190, 187, 186 },
-    { 151, 183, 183, 190, 190, 190, 190, 183, 183 },
-    { 152, 183, 187, 183, 187, 187, 183, 187, 183 },
-    { 153, 183, 186, 186, 183, 186, 183, 183, 186 },
-    { 154, 184, 188, 191, 193, 195, 196, 197, 198 },
-    { 155, 185, 185, 185, 185, 185, 185, 185, 185 },
-    { 156, 186, 185, 189, 194, 194, 189, 185, 186 },
-    { 157, 187, 185, 194, 192, 194, 192, 187, 185 },
-    { 158, 185, 185, 194, 194, 194, 194, 185, 185 },
-    { 159, 187, 185, 185, 187, 185, 187, 187, 185 },
-    { 160, 186, 185, 186, 185, 185, 186, 185, 186 },
-    { 161, 188, 200, 201, 202, 203, 195, 204, 205 },
-    { 162, 189, 189, 189, 189, 189, 189, 189, 189 },
-    { 163, 190, 194, 189, 192, 194, 190, 192, 189 },
-    { 164, 189, 194, 189, 194, 194, 189, 194, 189 },
-    { 165, 190, 189, 189, 190, 189, 190, 190, 189 },
-    { 166, 186, 186, 189, 189, 189, 189, 186, 186 },
-    { 167, 191, 201, 207, 208, 209, 210, 195, 211 },
-    { 168, 192, 192, 192, 192, 192, 192, 192, 192 },
-    { 169, 192, 194, 194, 192, 194, 192, 192, 194 },
-    { 170, 190, 192, 190, 192, 192, 190, 192, 190 },
-    { 171, 187, 187, 192, 192, 192, 192, 187, 187 },
-    { 172, 193, 202, 208, 213, 214, 215, 216, 195 },
-    { 173, 194, 194, 194, 194, 194, 194, 194, 194 },
-    { 174, 195, 203, 209, 214, 218, 208, 202, 201 },
-    { 175, 190, 190, 190, 190, 190, 190, 190, 190 },
-    { 176, 196, 195, 210, 215, 208, 220, 193, 191 },
-    { 177, 187, 187, 187, 187, 187, 187, 187, 187 },
-    { 178, 197, 204, 195, 216, 202, 193, 222, 188 },
-    { 179, 186, 186, 186, 186, 186, 186, 186, 186 },
-    { 180, 198, 205, 211, 195, 201, 191, 188, 224 },
-    { 181, 199, 206, 212, 217, 219, 221, 223, 225 },
-    { 182, 182, 182, 182, 182, 182, 182, 182, 182 },
-    { 183, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 184, 228, 228, 228, 228, 228, 228, 228, 228 },
-    { 185, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 186, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 187, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 188, 228, 230, 231, 232, 230, 228, 232, 231 },
-    { 189, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 190, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 191, 228, 231, 234, 235, 234, 235, 228, 231 },
-    { 192, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 193, 228, 232, 235, 237, 237, 235, 232, 228 },
-    { 194, 227, 227, 227, 227, 227, 227, 227, 227 },
-    { 195, 228, 230, 234, 237, 239, 235, 232, 231 },
-    { 196, 228, 228, 235, 235, 235, 235, 228, 228 },
-    { 197, 228, 232, 228, 232, 232, 228, 232, 228 },
-    { 198, 228, 231, 231, 228, 231, 228, 228, 231 },
-    { 199, 229, 233, 236, 238, 240, 241, 242, 243 },
-    { 200, 230, 230, 230, 230, 230, 230, 230, 230 },
-    { 201, 231, 230, 234, 239, 239, 234, 230, 231 },
-    { 202, 232, 230, 239, 237, 239, 237, 232, 230 },
-    { 203, 230, 230, 239, 239, 239, 239, 230, 230 },
-    { 204, 232, 230, 230, 232, 230, 232, 232, 230 },
-    { 205, 231, 230, 231, 230, 230, 231, 230, 231 },
-    { 206, 233, 245, 246, 247, 248, 240, 249, 250 },
-    { 207, 234, 234, 234, 234, 234, 234, 234, 234 },
-    { 208, 235, 239, 234, 237, 239, 235, 237, 234 },
-    { 209, 234, 239, 234, 239, 239, 234, 239, 234 },
-    { 210, 235, 234, 234, 235, 234, 235, 235, 234 },
-    { 211, 231, 231, 234, 234, 234, 234, 231, 231 },
-    { 212, 236, 246, 252, 253, 254, 255, 240, 256 },
-    { 213, 237, 237, 237, 237, 237, 237, 237, 237 },
-    { 214, 237, 239, 239, 237, 239, 237, 237, 239 },
-    { 215, 235, 237, 235, 237, 237, 235, 237, 235 },
-    { 216, 232, 232, 237, 237, 237, 237, 232, 232 },
-    { 217, 238, 247, 253, 258, 259, 260, 261, 240 },
-    { 218, 239, 239, 239, 239, 239, 239, 239, 239 },
-    { 219, 240, 248, 254, 259, 263, 253, 247, 246 },
-    { 220, 235, 235, 235, 235, 235, 235, 235, 235 },
-    { 221, 241, 240, 255, 260, 253, 265, 238, 236 },
-    { 222, 232, 232, 232, 232, 232, 232, 232, 232 },
-    { 223, 242, 249, 240, 261, 247, 238, 267, 233 },
-    { 224, 231, 231, 231, 231, 231, 231, 231, 231 },
-    { 225, 243, 250, 256, 240, 246, 236, 233, 269 },
-    { 226, 244, 251, 257, 262, 264, 266, 268, 270 }
-  };
+  const static int maxPeriod = 64;
+  uint64_t hashes[maxPeriod];
+  int count = 0;
 };
 
 class Life {
 public:
+  // Receives a span of cells in one call: values[i] is the state of cell (x + i, y),
+  // and may be 0
+  class RunVisitor {
+  public:
+    virtual void visit(int x, int y, int length, const byte* values) = 0;
+  };
+  virtual ~Life() {}
   // methods
   virtual void clear() = 0;
   virtual void set(int x, int y, byte value) = 0;
+  // Set length cells along a row, from (x, y) on, to value. Loaders set whole
+  // runs through this, so engines that can fill a run at once override it.
+  virtual void setRun(int x, int y, int length, byte value) {
+    for (int i = 0; i < length; i++) set(x + i, y, value);
+  }
+  // Set cells from rows packed the way InfiniteLife holds them, bits bits per
+  // cell, moved by (xOff, yOff). Each row is a marker, -(y + 1), then pairs of
+  // x and a 64 bit word (two ints, low half first) holding the cells from x on.
+  // Rows are in increasing y, and words in increasing x. See PackedPattern.h.
+  // If rng isn't null, each run of cells holding the all ones value, mask, is
+  // given a colour from 1 to nColors - 1 picked with rng, as loadRLE does for
+  // 'o' cells.
+  virtual void setPacked(int xOff, int yOff, const int* rows, int length, int bits, LifeRandom* rng = 0,
+                         int nColors = 0) {
+    int y = 0;
+    int mask = (1 << bits) - 1;
+    RandomColours colours(rng, nColors, mask);
+    for (int i = 0; i < length; i++) {
+      if (rows[i] < 0) {
+        y = -rows[i] - 1 + yOff;
+        continue;
+      }
+      int x = rows[i] + xOff;
+      uint64_t word = (uint32_t)rows[i + 1] | (uint64_t)(uint32_t)rows[i + 2] << 32;
+      i += 2;
+      for (; word; word >>= bits, x++) {
+        if (word & mask) set(x, y, colours.colour(x, y, word & mask));
+      }
+    }
+  }
   virtual void nextGeneration() = 0;
-  virtual void iterateLive(std::function<void(int x, int y, int value)> lambda) = 0;
+  virtual void iterateLiveRuns(RunVisitor& visitor) = 0;
+  virtual void iterateLive(std::function<void(int x, int y, int value)> lambda) {
+    forEachLive([&lambda](int x, int y, int value) {
+      lambda(x, y, value);
+    });
+  }
   virtual void setRule(int nStates, TreeRule* rule) = 0;
+  // Calls lambda for each cell that differs from the previous generation, with
+  // value 0 for cells that died. Returns false without calling lambda if the
+  // engine can't tell, for example because cells were set since the last step.
+  virtual bool iterateChanged(std::function<void(int x, int y, int value)> /*lambda*/) {
+    return false;
+  }
+  // 64 bit hash of the whole state, the sum of cellHash over the live cells so
+  // that engines can keep it up to date as cells change
+  virtual uint64_t getHash() {
+    uint64_t hash = 0;
+    forEachLive([&hash](int x, int y, int value) {
+      hash += cellHash(x, y, value);
+    });
+    return hash;
+  }
+  // Bytes of heap holding the cells, for comparing engines
+  virtual size_t getStateBytes() {
+    return 0;
+  }
+  // Dead cells hash to 0
+  static uint64_t cellHash(int x, int y, int value) {
+    return value ? mix(mix(((uint64_t)(uint32_t)x << 32) | (uint32_t)y) + value) : 0;
+  }
+  // Inlinable alternatives to iterateLive, costing one virtual call per span
+  // rather than an indirect call per cell. Engines also provide these directly,
+  // for when the engine type is known.
+  template <class F>
+  void forEachLiveRun(F&& f) {
+    RunAdapter<F> adapter(f);
+    iterateLiveRuns(adapter);
+  }
+  template <class F>
+  void forEachLive(F&& f) {
+    forEachLiveRun([&f](int x, int y, int length, const byte* values) {
+      for (int i = 0; i < length; i++) {
+        if (values[i]) f(x + i, y, values[i]);
+      }
+    });
+  }
+protected:
+  // Picks the colours of runs of random colour cells for setPacked, the same
+  // colour for as long as the run goes on along a row
+  class RandomColours {
+  public:
+    RandomColours(LifeRandom* rng, int nColors, int marker)
+      : rng(rng), nColors(nColors), marker(marker) {}
+    int colour(int x, int y, int value) {
+      if (!rng || value != marker) return value;
+      if (x != lastX + 1 || y != lastY) last = rng->random(1, nColors);
+      lastX = x;
+      lastY = y;
+      return last;
+    }
+  private:
+    LifeRandom* rng;
+    int nColors;
+    int marker;
+    int lastX = INT_MIN;
+    int lastY = INT_MIN;
+    int last = 0;
+  };
 private:
+  // splitmix64 finalizer
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+  template <class F>
+  class RunAdapter : public RunVisitor {
+  public:
+    RunAdapter(F& f)
+      : f(f) {}
+    void visit(int x, int y, int length, const byte* values) {
+      f(x, y, length, values);
+    }
+  private:
+    F& f;
+  };
 };
 
 class InfiniteLife : public Life {
 public:
-  InfiniteLife(int nStates, TreeRule* treeRule) : treeRule(treeRule) {
-    data1 = new Data(10000);
-    data2 = new Data(10000);
+  const static int defaultMaxLength = 32768;
+
+  // Each of the two ping-pong buffers starts with room for initialLength ints,
+  // and grows geometrically as needed up to a hard cap of maxLength ints.
+  InfiniteLife(int nStates, TreeRule* treeRule, int initialLength = 10000, int maxLength = defaultMaxLength)
+    : treeRule(treeRule) {
+    data1 = new Data(initialLength, maxLength);
+    data2 = new Data(initialLength, maxLength);
     data = data1;
     next = data2;
     setRule(nStates, treeRule);
   }
   ~InfiniteLife() {
-    free(data1);
-    free(data2);
+    delete data1;
+    delete data2;
   }
+  // Cells are packed 1, 2, 4 or 8 bits each, whichever is the least that holds
+  // nStates, and the generation is stepped by code specialized for that width
   virtual void setRule(int nStates, TreeRule* rule) {
     treeRule = rule;
-    bitsPerPixel = -1;
-    for (int bitsPerPixel=0; bitsPerPixel<=8; bitsPerPixel++) {
-      if ((1<<bitsPerPixel) >= nStates) {
-        break;
-      }
-    }
-    pixelsPerData = 32 / bitsPerPixel;
+    compiledRule.compile(nStates, rule);
+    bitsPerPixel = bitsPerCell(nStates);
+    pixelsPerData = 64 / bitsPerPixel;
     mask = (1 << bitsPerPixel) - 1;
     clear();
   }
+  static int bitsPerCell(int nStates) {
+    int bits = 1;
+    while (bits < 8 && (1 << bits) < nStates) bits *= 2;
+    return bits;
+  }
   virtual void clear() {
+    culledCells += data->culled;
     data->clear();
+    data->allChanged = true;
+    cullRadius = INT_MAX;
+    hasPrevious = false;
+    hash = 0;
+    hashValid = true;
+  }
+  // When a generation does not fit in the storage cap, cells further than the
+  // cull radius from this point are dropped
+  void setCullCenter(int x, int y) {
+    cullX = x;
+    cullY = y;
+  }
+  int getCullRadius() {
+    return cullRadius;
+  }
+  // Number of cells dropped so far because they were culled or did not fit
+  int getCulledCells() {
+    return culledCells + data->culled;
+  }
+#ifndef ARDUINO
+  // Step large generations in parallel bands on the given pool (or serially if 0)
+  void setThreadPool(ThreadPool* pool) {
+    threadPool = pool;
+  }
+#endif
+  // Largest number of ints used by a single generation so far
+  int getHighWaterMark() {
+    return max(data1->highWaterMark, data2->highWaterMark);
+  }
+  // Number of ints currently allocated for both buffers
+  int getAllocLength() {
+    return data1->allocLength + data2->allocLength;
+  }
+  virtual size_t getStateBytes() {
+    return sizeof(int) * getAllocLength();
   }
   // Currently we only support calling set for increasing x,y
   virtual void set(int x, int y, byte value) {
     set(this->data, x, y, value);
+    data->allChanged = true;
+    hasPrevious = false;
+    hashValid = false;
+  }
+  // Runs are or'ed into the packed words a word at a time
+  virtual void setRun(int x, int y, int length, byte value) {
+    if (!value || length <= 0) return;
+    if (abs(y - cullY) > cullRadius || abs(x - cullX) > cullRadius || abs(x + length - 1 - cullX) > cullRadius) {
+      for (int i = 0; i < length; i++) set(this->data, x + i, y, value);
+    } else {
+      switch (bitsPerPixel) {
+        case 1:
+          fill<1>(data, x, y, length, value);
+          break;
+        case 2:
+          fill<2>(data, x, y, length, value);
+          break;
+        case 4:
+          fill<4>(data, x, y, length, value);
+          break;
+        default:
+          fill<8>(data, x, y, length, value);
+      }
+    }
+    data->allChanged = true;
+    hasPrevious = false;
+    hashValid = false;
+  }
+  // Rows packed at the width this rule uses are copied straight into an empty
+  // universe, only moving the row markers and x positions, and colouring any
+  // random colour cells in place
+  virtual void setPacked(int xOff, int yOff, const int* rows, int length, int bits, LifeRandom* rng = 0,
+                         int nColors = 0) {
+    if (bits != bitsPerPixel || data->dataLength || cullRadius != INT_MAX || length == 0 || !data->reserve(length)) {
+      Life::setPacked(xOff, yOff, rows, length, bits, rng, nColors);
+      return;
+    }
+    RandomColours colours(rng, nColors, mask);
+    int* out = data->data;
+    int* lastRow = 0;
+    int* lastWord = 0;
+    int y = 0;
+    for (const int* p = rows; p < rows + length;) {
+      if (*p < 0) {
+        lastRow = out;
+        y = -*p - 1;
+        *out++ = *p++ - yOff - (offset - 1);
+      } else {
+        lastWord = out;
+        int x = *p;
+        *out++ = *p++ + xOff + offset;
+        Word word = readWord(p);
+        p += wordInts;
+        if (rng) {
+          for (int i = 0; i < pixelsPerData; i++) {
+            int value = (word >> (i * bits)) & mask;
+            if (value) word = (word & ~((Word)mask << (i * bits))) | (Word)colours.colour(x + i, y, value) << (i * bits);
+          }
+        }
+        *out++ = (uint32_t)word;
+        *out++ = (uint32_t)(word >> 32);
+      }
+    }
+    data->dataLength = length;
+    data->yCurrent = -*lastRow - offset;
+    data->xCurrent = *lastWord - offset;
+    data->allChanged = true;
+    hasPrevious = false;
+    hashValid = false;
+  }
+  // Number of tiles that were stepped through the rule in the last generation,
+  // or -1 if every tile was
+  int getActiveTiles() {
+    return activeAll ? -1 : activeTiles.size();
   }
 
   virtual void dump() {
@@ -556,150 +935,124 @@ public:
   }
 
   virtual void nextGeneration() {
-    if (data->dataLength == 0) return;
-    Row prevRow(*this);   // Row at y-1
-    Row currRow(*this);   // Row at y
-    Row nextRow(*this);   // Row at y+1
-    Row nextLive(*this);  // Next live row after nextRow
-
-    // Add marker to avoid having to constantly check dataLength
-    data->data[data->dataLength] = -1;
-
-    nextLive.init(data->data);
-    int y = -1;
-
-    next->clear();
-
-    // Keeps track of the neighborhood, and calls callback to set new live cells as needed
-    NeighborHood neighborhood([this](int x, int y, int* neighbors) {
-      //Serial.printf("x=%d y=%d, [%d,%d,%d,%d,%d,%d,%d,%d,%d]\n", x, y, neighbors[0], neighbors[1], neighbors[2], neighbors[3], neighbors[4], neighbors[5], neighbors[6], neighbors[7], neighbors[8]);
-      set(next, x, y, treeRule->transition(neighbors));
-    });
-    // Loop over rows
+    hasPrevious = true;
+    if (data->dataLength == 0) {
+      next->clear();
+      return;
+    }
+    findActiveTiles();
+    // If the next generation does not fit, shrink the region we keep and try again
     for (;;) {
-      if (currRow.wasDead() && nextRow.wasDead()) {
-        if (nextLive.wasDead()) break;
-        // Skip to make nextLive the next row
-        prevRow.init();
-        currRow.init();
-        nextRow.init(nextLive);
-        nextLive.advance();
-        y = nextRow.getY() - 1;
-      } else {
-        // Move to next row
-        prevRow.init(currRow);
-        //Serial.printf("Advancing currRow\n");
-        currRow.init(nextRow);
-        y++;
-        if (nextLive.getY() == y + 1) {
-          nextRow.init(nextLive);
-          nextLive.advance();
-        } else {
-          nextRow.init();
-        }
-      }
-      // Handle current row
-      neighborhood.startRow(y);
-      for (;;) {
-        int x = min3(prevRow.getX(), currRow.getX(), nextRow.getX());
-        if (x == INT_MAX) {
-          break;
-        }
-        // Set neighborhoood, this will call back to do the update as necessary
-        neighborhood.load(x, prevRow.getAndConditionallyIncrement(x), currRow.getAndConditionallyIncrement(x), nextRow.getAndConditionallyIncrement(x));
-      }
-      neighborhood.endRow(y);
+      step();
+      if (!next->overflowed) break;
+      int extent = min(getExtent(data), cullRadius);
+      if (extent <= minCullRadius) break;
+      cullRadius = max(extent * 3 / 4, (int)minCullRadius);
     }
+    culledCells += data->culled;
     Data* temp = data;
     data = next;
     next = temp;
     //Serial.println(data->dataLength);
+    // Culled cells were counted in the hash as if they had been kept
+    hash += data->hashDelta;
+    if (data->culled) hashValid = false;
   }
-  virtual void iterateLive(std::function<void(int x, int y, int value)> lambda) {
-    int x = 0, y = 0;
+  virtual uint64_t getHash() {
+    if (!hashValid) {
+      hash = Life::getHash();
+      hashValid = true;
+    }
+    return hash;
+  }
+  // The previous generation is still in next, so walk both in step
+  virtual bool iterateChanged(std::function<void(int x, int y, int value)> lambda) {
+    if (!hasPrevious) return false;
+    Cursor curr(*this, data), prev(*this, next);
+    while (!curr.done || !prev.done) {
+      long order = curr.done ? 1 : prev.done ? -1 : curr.y != prev.y ? (long)curr.y - prev.y : (long)curr.x - prev.x;
+      if (order < 0) {
+        lambda(curr.x, curr.y, curr.value);
+        curr.advance();
+      } else if (order > 0) {
+        lambda(prev.x, prev.y, 0);
+        prev.advance();
+      } else {
+        if (curr.value != prev.value) lambda(curr.x, curr.y, curr.value);
+        curr.advance();
+        prev.advance();
+      }
+    }
+    return true;
+  }
+  virtual void iterateLiveRuns(RunVisitor& visitor) {
+    forEachLiveRun([&visitor](int x, int y, int length, const byte* values) {
+      visitor.visit(x, y, length, values);
+    });
+  }
+  // Adjacent packed words are merged into one span
+  template <class F>
+  void forEachLiveRun(F&& f) {
+    byte values[maxRun];
+    int length = 0;
+    int runX = 0, y = 0;
     for (int i = 0; i < data->dataLength; i++) {
       int datum = data->data[i];
       if (datum < 0) {
+        if (length) f(runX, y, length, values);
+        length = 0;
         y = -datum - offset;
       } else {
-        x = datum - offset;
-        unsigned int value = data->data[++i];
+        int x = datum - offset;
+        if (length && (x != runX + length || length > maxRun - pixelsPerData)) {
+          f(runX, y, length, values);
+          length = 0;
+        }
+        if (!length) runX = x;
+        Word value = readWord(data->data + i + 1);
+        i += wordInts;
         while (value != 0) {
-          if (value & mask) {
-            lambda(x, y, value & mask);
-          }
-          x += 1;
+          values[length++] = value & mask;
           value >>= bitsPerPixel;
         }
       }
     }
+    if (length) f(runX, y, length, values);
+  }
+  template <class F>
+  void forEachLive(F&& f) {
+    forEachLiveRun([&f](int x, int y, int length, const byte* values) {
+      for (int i = 0; i < length; i++) {
+        if (values[i]) f(x + i, y, values[i]);
+      }
+    });
   }
 private:
-  class NeighborHood {
-  public:
+  // Packed cells are held in 64 bit words, each taking two ints of the data,
+  // low half first. After a row marker, -(y + offset), come pairs of x + offset
+  // and the word holding the cells from x on, bitsPerPixel bits each.
+  typedef uint64_t Word;
+  const static int wordInts = 2;
+  static Word readWord(const int* p) {
+    return (uint32_t)p[0] | (Word)(uint32_t)p[1] << 32;
+  }
 
-    NeighborHood(std::function<void(int x, int y, int* neighbors)> lambda) {
-      this->lambda = lambda;
-    }
-    void load(int x, int px, int cx, int nx) {
-      if (x - this->x == 1) {
-        shiftAndCall(px, cx, nx);
-      } else if (x - this->x == 2) {
-        shiftAndCall(0, 0, 0);
-        shiftAndCall(px, cx, nx);
-      } else {
-        if (this->x != INT_MIN) {
-          shiftAndCall(0, 0, 0);
-          shiftAndCall(0, 0, 0);
-        }
-        this->x = x - 1;
-        shiftAndCall(px, cx, nx);
-      }
-    }
-    void endRow(int y) {
-      shiftAndCall(0, 0, 0);
-      shiftAndCall(0, 0, 0);
-    }
-    void startRow(int y) {
-      this->y = y;
-      this->x = INT_MIN;
-      clear();
-    }
-  private:
-    void clear() {
-      memset(neighbors, 0, sizeof(neighbors[0]) * 9);
-    }
-    void shiftAndCall(int a, int b, int c) {
-      shift(a, b, c);
-      lambda(this->x, this->y, neighbors);
-      this->x++;
-    }
-    void shift(int a, int b, int c) {
-      // Use the same order as SimpleLife
-      //    get(x - 1, y - 1), get(x, y - 1), get(x + 1, y - 1),
-      //    get(x - 1, y), get(x + 1, y),
-      //    get(x - 1, y + 1), get(x, y + 1), get(x + 1, y + 1),
-      //    get(x, y)
-      neighbors[0] = neighbors[1];
-      neighbors[3] = neighbors[8];
-      neighbors[5] = neighbors[6];
-      neighbors[1] = neighbors[2];
-      neighbors[8] = neighbors[4];
-      neighbors[6] = neighbors[7];
-      neighbors[2] = a;
-      neighbors[4] = b;
-      neighbors[7] = c;
+  // Computes the generation after data into next
+  void step() {
+    // Add marker to avoid having to constantly check dataLength
+    data->data[data->dataLength] = -1;
+#ifndef ARDUINO
+    if (threadPool && data->dataLength >= minParallelLength) {
+      stepParallel();
+      return;
     }
-    std::function<void(int x, int y, int* neighbors)> lambda;
-    int neighbors[9];
-    int x;
-    int y;
-  };
+#endif
+    step(next, data->data, INT_MIN, INT_MAX);
+  }
 
   class Row {
   public:
-    Row(const InfiniteLife& parent)
-      : parent(parent) {
+    Row() {
       init();
     }
     void init(const Row& other) {
@@ -719,22 +1072,20 @@ private:
         if (currY == -1) {
           currX = INT_MAX;
           currY = INT_MIN;
-          dead = true;
         } else {
           currY = -currY - offset;
           currX = *(data++) - offset;
-          value = *(data++);
-          dead = false;
+          value = readWord(data);
+          data += wordInts;
         }
       } else {
         currY = INT_MIN;
         currX = INT_MAX;
-        dead = true;
       }
     }
     void advance() {
       if (!end) {
-        while (*data >= 0) data += 2;
+        while (*data >= 0) data += 1 + wordInts;
         end = data;
       }
       init(end);
@@ -745,37 +1096,22 @@ private:
     int getY() {
       return currY;
     }
-    int nextX() {
-      if (dead) return INT_MAX;
-
-      while (value) {
-        value >>= parent.bitsPerPixel;
-        currX++;
-        if (value & parent.mask) {
-          return currX;
-        }
-      }
+    const int* getStart() {
+      return start;
+    }
+    // The current word, with its first cell at getX()
+    Word getWord() {
+      return value;
+    }
+    void nextWord() {
       currX = *(data++);
       if (currX < 0) {
-        end = data;
-        dead = true;
+        end = data - 1;
         currX = INT_MAX;
       } else {
         currX -= offset;
-        value = *(data++);
-      }
-      return currX;
-    }
-    int getValue() {
-      return value & parent.mask;
-    }
-    int getAndConditionallyIncrement(int x) {
-      if (x == currX) {
-        int rValue = getValue();
-        nextX();
-        return rValue;
-      } else {
-        return 0;
+        value = readWord(data);
+        data += wordInts;
       }
     }
     bool wasDead() {
@@ -783,21 +1119,98 @@ private:
     }
 
   private:
-    const InfiniteLife& parent;
     const int* start;
     const int* data;
     const int* end;
     int currX;
     int currY;
-    unsigned int value;
-    bool dead;
+    Word value;
+  };
+
+  // Set of tiles, as an open addressing hash table of packed tile coordinates
+  class TileSet {
+  public:
+    TileSet() {}
+    TileSet(const TileSet&) = delete;
+    ~TileSet() {
+      free(keys);
+    }
+    void clear() {
+      if (count) memset(keys, 0, sizeof(uint64_t) * capacity);
+      count = 0;
+    }
+    int size() {
+      return count;
+    }
+    bool contains(int tx, int ty) const {
+      if (!count) return false;
+      uint64_t key = pack(tx, ty);
+      for (int i = hash(key) & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+        if (keys[i] == key) return true;
+        if (keys[i] == 0) return false;
+      }
+    }
+    void insert(int tx, int ty) {
+      if ((count + 1) * 2 > capacity) grow();
+      insert(pack(tx, ty));
+    }
+    void insert(const TileSet& other) {
+      other.forEach([this](int tx, int ty) {
+        insert(tx, ty);
+      });
+    }
+    template <class F>
+    void forEach(F&& f) const {
+      for (int i = 0; i < capacity; i++) {
+        if (keys[i]) f((int)(keys[i] >> 32) - bias, (int)(keys[i] & 0xffffffff) - bias);
+      }
+    }
+  private:
+    // Tile coordinates are well within +-bias, so no key is ever 0 (empty)
+    static const int bias = 1 << 28;
+    static uint64_t pack(int tx, int ty) {
+      return ((uint64_t)(tx + bias) << 32) | (uint32_t)(ty + bias);
+    }
+    static uint32_t hash(uint64_t key) {
+      key *= 0x9E3779B97F4A7C15ULL;
+      return key >> 32;
+    }
+    void insert(uint64_t key) {
+      for (int i = hash(key) & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+        if (keys[i] == key) return;
+        if (keys[i] == 0) {
+          keys[i] = key;
+          count++;
+          return;
+        }
+      }
+    }
+    void grow() {
+      uint64_t* old = keys;
+      int oldCapacity = capacity;
+      capacity = capacity ? capacity * 2 : 64;
+      keys = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+      count = 0;
+      for (int i = 0; i < oldCapacity; i++) {
+        if (old[i]) insert(old[i]);
+      }
+      free(old);
+    }
+    uint64_t* keys = 0;
+    int capacity = 0;
+    int count = 0;
   };
 
+  // Growable buffer holding one generation in the row encoding. The buffer is
+  // reused from generation to generation, and only ever grows (by doubling), so
+  // once a pattern has reached its working size there is no further heap traffic.
   class Data {
   public:
-    Data(int allocLength) {
-      this->allocLength = allocLength;
-      this->data = (int*)malloc(sizeof(int) * allocLength);
+    Data(int allocLength, int maxLength) {
+      this->allocLength = min(allocLength, maxLength);
+      this->maxLength = maxLength;
+      this->data = (int*)malloc(sizeof(int) * this->allocLength);
+      highWaterMark = 0;
       clear();
     }
     ~Data() {
@@ -807,42 +1220,520 @@ private:
       dataLength = 0;
       xCurrent = INT_MIN;
       yCurrent = INT_MIN;
+      overflowed = false;
+      culled = 0;
+      hashDelta = 0;
+      allChanged = false;
+      changedTiles.clear();
+    }
+    // Make room for n more ints, plus one for the end of data marker
+    bool reserve(int n) {
+      int needed = dataLength + n + 1;
+      if (needed > allocLength && !grow(needed)) {
+        overflowed = true;
+        return false;
+      }
+      if (needed > highWaterMark) highWaterMark = needed;
+      return true;
     }
     int allocLength;
+    int maxLength;
     int dataLength;
+    int highWaterMark;
     int* data;
     int xCurrent;
     int yCurrent;
+    bool overflowed;
+    int culled;
+    // Change to the state hash from the previous generation
+    uint64_t hashDelta;
+    // Cull radius in effect when this generation was computed
+    int cullRadius = INT_MAX;
+    // Tiles with a cell that differs from the previous generation
+    TileSet changedTiles;
+    // Set when cells were changed directly, rather than by stepping
+    bool allChanged;
+  private:
+    bool grow(int needed) {
+      if (needed > maxLength) return false;
+      int newLength = allocLength;
+      while (newLength < needed) newLength = newLength > maxLength / 2 ? maxLength : newLength * 2;
+      int* newData = (int*)realloc(data, sizeof(int) * newLength);
+      if (!newData) return false;
+      data = newData;
+      allocLength = newLength;
+      return true;
+    }
+  };
+
+  // Steps through the live cells of a generation in (y, x) order
+  class Cursor {
+  public:
+    Cursor(const InfiniteLife& parent, const Data* d)
+      : parent(parent), data(d->data), end(d->data + d->dataLength) {
+      advance();
+    }
+    void advance() {
+      for (;;) {
+        while (bits) {
+          value = bits & parent.mask;
+          bits >>= parent.bitsPerPixel;
+          x = wordX++;
+          if (value) return;
+        }
+        if (data == end) {
+          done = true;
+          return;
+        }
+        int datum = *(data++);
+        if (datum < 0) {
+          y = -datum - offset;
+        } else {
+          wordX = datum - offset;
+          bits = readWord(data);
+          data += wordInts;
+        }
+      }
+    }
+    bool done = false;
+    int x = 0;
+    int y = 0;
+    int value = 0;
+  private:
+    const InfiniteLife& parent;
+    const int* data;
+    const int* end;
+    Word bits = 0;
+    int wordX = 0;
+  };
+
+  // Evaluates the rule along a row. Whole words from the rows above, at and
+  // below y are unpacked into line buffers, for as long as their neighborhoods
+  // run together, and the span is then swept with a sliding window. Windows
+  // with no live cells are skipped, lambda gives the new state of the rest, and
+  // the span's new states are appended to out in one go.
+  // Cells are bits wide. If counted, the window counts (see
+  // CompiledRule::getCountWeights) are kept up to date as well, a column at a
+  // time.
+  template <class F, int bits, bool counted>
+  class NeighborHood {
+  public:
+    NeighborHood(InfiniteLife& parent, Data* out, F& lambda, const uint32_t* weights)
+      : parent(parent), out(out), lambda(lambda), weights(weights) {
+      memset(cells, 0, sizeof(cells));
+    }
+    void startRow(int y) {
+      this->y = y;
+      length = 0;
+    }
+    // Add a word from row (0 above, 1 at and 2 below y) with its first cell at x
+    void load(int row, int x, Word value) {
+      if (length && x - 2 >= xStart + length) {
+        // Nothing in between, so finish the span
+        endRow();
+      }
+      if (!length) {
+        xStart = x - 2;
+      } else if (x - xStart + cellsPerWord + 2 > maxSpan) {
+        // Out of room, so finish the cells this word can't affect
+        sweep(x - xStart - 2);
+      }
+      int i = x - xStart;
+      for (; value; value >>= bits) cells[i++][row] = value & mask;
+      // Keep two empty columns after the last cell
+      if (i + 2 > length) length = i + 2;
+    }
+    void endRow() {
+      if (length) sweep(length - 2);
+      length = 0;
+    }
+  private:
+    const static int maxSpan = 256;
+    const static int cellsPerWord = 64 / bits;
+    const static int mask = (1 << bits) - 1;
+
+    // Call lambda for the cells at positions 1 to last, then keep the columns
+    // from last on, which the following cells still need. Columns from length
+    // on are always clear, and the others are cleared once they are done with.
+    void sweep(int last) {
+      if (counted) {
+        memset(columns, 0, sizeof(columns));
+        counts = 0;
+      }
+      // The window is full once the first cell's column is added
+      shift(0);
+      shift(1);
+      for (int i = 2; i <= last + 1; i++) {
+        shift(i);
+        results[i - 1] = occupied[0] | occupied[1] | occupied[2] ? lambda(xStart + i - 1, y, neighbors, counts) : 0;
+        memset(cells[i - 2], 0, sizeof(cells[0]));
+      }
+      parent.setRun<bits>(out, xStart + 1, y, results + 1, last);
+      // Unless that was the whole span, move the rest to the start
+      if (last < length - 2) {
+        memmove(cells, cells + last, sizeof(cells[0]) * (length - last));
+        memset(cells + length - last, 0, sizeof(cells[0]) * last);
+      }
+      xStart += last;
+      length -= last;
+    }
+    void shift(int i) {
+      int a = cells[i][0], b = cells[i][1], c = cells[i][2];
+      // Use the same order as SimpleLife
+      //    get(x - 1, y - 1), get(x, y - 1), get(x + 1, y - 1),
+      //    get(x - 1, y), get(x + 1, y),
+      //    get(x - 1, y + 1), get(x, y + 1), get(x + 1, y + 1),
+      //    get(x, y)
+      neighbors[0] = neighbors[1];
+      neighbors[3] = neighbors[8];
+      neighbors[5] = neighbors[6];
+      neighbors[1] = neighbors[2];
+      neighbors[8] = neighbors[4];
+      neighbors[6] = neighbors[7];
+      neighbors[2] = a;
+      neighbors[4] = b;
+      neighbors[7] = c;
+      occupied[0] = occupied[1];
+      occupied[1] = occupied[2];
+      occupied[2] = a | b | c;
+      if (counted) {
+        uint32_t column = weights[a] + weights[b] + weights[c];
+        counts += column - columns[0];
+        columns[0] = columns[1];
+        columns[1] = columns[2];
+        columns[2] = column;
+      }
+    }
+    InfiniteLife& parent;
+    Data* out;
+    F& lambda;
+    const uint32_t* weights;
+    // Columns of the span from xStart, each with the cells above, at and below
+    // y, padded to four bytes
+    byte cells[maxSpan][4];
+    byte results[maxSpan];
+    int xStart;
+    int length;
+    int y;
+    int neighbors[9];
+    // Which of the three columns of the window have live cells, their counts,
+    // and the counts of the whole window
+    int occupied[3];
+    uint32_t columns[3];
+    uint32_t counts;
   };
 
+  // Computes rows yStart <= y < yEnd of the next generation into out. start
+  // must point at a row marker in data, at or before the row at yStart-1.
+  void step(Data* out, const int* start, int yStart, int yEnd) {
+    switch (bitsPerPixel) {
+      case 1:
+        stepPacked<1>(out, start, yStart, yEnd);
+        break;
+      case 2:
+        stepPacked<2>(out, start, yStart, yEnd);
+        break;
+      case 4:
+        stepPacked<4>(out, start, yStart, yEnd);
+        break;
+      default:
+        stepPacked<8>(out, start, yStart, yEnd);
+    }
+  }
+  template <int bits>
+  void stepPacked(Data* out, const int* start, int yStart, int yEnd) {
+    if (compiledRule.getCountWeights()) {
+      stepPacked<bits, true>(out, start, yStart, yEnd);
+    } else {
+      stepPacked<bits, false>(out, start, yStart, yEnd);
+    }
+  }
+  template <int bits, bool counted>
+  void stepPacked(Data* out, const int* start, int yStart, int yEnd) {
+    Row prevRow;   // Row at y-1
+    Row currRow;   // Row at y
+    Row nextRow;   // Row at y+1
+    Row nextLive;  // Next live row after nextRow
+
+    nextLive.init(start);
+    int y = -1;
+
+    out->clear();
+    out->cullRadius = cullRadius;
+    // Rows can only be copied as is if they were culled the same way
+    bool copyRows = !activeAll && data->cullRadius == cullRadius;
+
+    // Keeps track of the neighborhood, and calls callback for the new state of cells as needed.
+    // Cells in tiles with no changes nearby are copied forward without evaluating the rule.
+    int lastTx = INT_MIN, lastTy = INT_MIN;
+    bool lastActive = true;
+    int changedTx = INT_MIN, changedTy = INT_MIN;
+    const uint32_t* weights = compiledRule.getCountWeights();
+    auto update = [&](int x, int y, int* neighbors, uint32_t counts) {
+      //Serial.printf("x=%d y=%d, [%d,%d,%d,%d,%d,%d,%d,%d,%d]\n", x, y, neighbors[0], neighbors[1], neighbors[2], neighbors[3], neighbors[4], neighbors[5], neighbors[6], neighbors[7], neighbors[8]);
+      int tx = x >> tileShift, ty = y >> tileShift;
+      if (tx != lastTx || ty != lastTy) {
+        lastTx = tx;
+        lastTy = ty;
+        lastActive = activeAll || activeTiles.contains(tx, ty);
+      }
+      if (!lastActive) return neighbors[8];
+      int value = counted ? compiledRule.transition(neighbors[8], counts) : compiledRule.transition(neighbors);
+      if (value != neighbors[8]) {
+        out->hashDelta += cellHash(x, y, value) - cellHash(x, y, neighbors[8]);
+        if (tx != changedTx || ty != changedTy) {
+          changedTx = tx;
+          changedTy = ty;
+          out->changedTiles.insert(tx, ty);
+        }
+      }
+      return value;
+    };
+    NeighborHood<decltype(update), bits, counted> neighborhood(*this, out, update, weights);
+    // Loop over rows
+    for (;;) {
+      if (currRow.wasDead() && nextRow.wasDead()) {
+        if (nextLive.wasDead()) break;
+        // Skip to make nextLive the next row
+        prevRow.init();
+        currRow.init();
+        nextRow.init(nextLive);
+        nextLive.advance();
+        y = nextRow.getY() - 1;
+      } else {
+        // Move to next row
+        prevRow.init(currRow);
+        //Serial.printf("Advancing currRow\n");
+        currRow.init(nextRow);
+        y++;
+        if (nextLive.getY() == y + 1) {
+          nextRow.init(nextLive);
+          nextLive.advance();
+        } else {
+          nextRow.init();
+        }
+      }
+      if (y >= yEnd) break;
+      if (y < yStart) continue;
+      if (copyRows && !activeRows.contains(0, y >> tileShift)) {
+        if (!currRow.wasDead()) copyRow(out, currRow.getStart());
+        continue;
+      }
+      // Handle current row, taking words from the three rows in order of x. The
+      // neighborhood calls back to do the update as necessary
+      neighborhood.startRow(y);
+      for (;;) {
+        int px = prevRow.getX(), cx = currRow.getX(), nx = nextRow.getX();
+        if (px <= cx && px <= nx) {
+          if (px == INT_MAX) break;
+          neighborhood.load(0, px, prevRow.getWord());
+          prevRow.nextWord();
+        } else if (cx <= nx) {
+          neighborhood.load(1, cx, currRow.getWord());
+          currRow.nextWord();
+        } else {
+          neighborhood.load(2, nx, nextRow.getWord());
+          nextRow.nextWord();
+        }
+      }
+      neighborhood.endRow();
+    }
+  }
+
+#ifndef ARDUINO
+  // Split the rows into bands of roughly equal amounts of data, step each band
+  // into its own buffer on the thread pool, then concatenate them in order, so
+  // the result is identical to stepping serially
+  void stepParallel() {
+    int nBands = threadPool->getThreads() * 4;
+    while ((int)bands.size() < nBands) {
+      bands.push_back(std::unique_ptr<Data>(new Data(data->allocLength / nBands + 16, data->maxLength)));
+    }
+    std::vector<const int*> starts;
+    std::vector<int> yStarts;
+    const int* previous = 0;
+    for (int i = 0; i < data->dataLength; i++) {
+      int datum = data->data[i];
+      if (datum >= 0) {
+        i += wordInts;
+        continue;
+      }
+      int y = -datum - offset;
+      if (i >= (long)data->dataLength * (int)starts.size() / nBands) {
+        // Band starts at row y, but needs the row above too if there is one
+        bool above = previous && -*previous - offset == y - 1;
+        starts.push_back(above ? previous : data->data + i);
+        yStarts.push_back(starts.size() == 1 ? INT_MIN : y);
+      }
+      previous = data->data + i;
+    }
+    nBands = starts.size();
+    threadPool->parallelFor(nBands, [&](int b) {
+      step(bands[b].get(), starts[b], yStarts[b], b + 1 < nBands ? yStarts[b + 1] : INT_MAX);
+    });
+    next->clear();
+    int total = 0;
+    for (int b = 0; b < nBands; b++) {
+      total += bands[b]->dataLength;
+      next->culled += bands[b]->culled;
+      next->hashDelta += bands[b]->hashDelta;
+      next->changedTiles.insert(bands[b]->changedTiles);
+      if (bands[b]->overflowed) next->overflowed = true;
+    }
+    if (!next->reserve(total)) return;
+    next->cullRadius = cullRadius;
+    for (int b = 0; b < nBands; b++) {
+      Data* band = bands[b].get();
+      if (band->dataLength == 0) continue;
+      memcpy(next->data + next->dataLength, band->data, sizeof(int) * band->dataLength);
+      next->dataLength += band->dataLength;
+      next->xCurrent = band->xCurrent;
+      next->yCurrent = band->yCurrent;
+    }
+  }
+#endif
+
+  // Tiles that may change in the next generation are those next to a tile that
+  // changed in the last one
+  void findActiveTiles() {
+    activeAll = data->allChanged;
+    activeTiles.clear();
+    activeRows.clear();
+    if (activeAll) return;
+    data->changedTiles.forEach([this](int tx, int ty) {
+      for (int dy = -1; dy <= 1; dy++) {
+        activeRows.insert(0, ty + dy);
+        for (int dx = -1; dx <= 1; dx++) {
+          activeTiles.insert(tx + dx, ty + dy);
+        }
+      }
+    });
+  }
+
+  // Append the row starting at the given marker unchanged
+  void copyRow(Data* out, const int* row) {
+    const int* end = row + 1;
+    while (*end >= 0) end += 1 + wordInts;
+    int length = end - row;
+    if (!out->reserve(length)) {
+      out->culled += (length - 1) / (1 + wordInts);
+      return;
+    }
+    memcpy(out->data + out->dataLength, row, sizeof(int) * length);
+    out->dataLength += length;
+    out->yCurrent = -*row - offset;
+    out->xCurrent = end[-1 - wordInts] - offset;
+  }
+
+  // Largest distance (in x or y) of any live cell from the cull center
+  int getExtent(const Data* data) {
+    int extent = 0;
+    for (int i = 0; i < data->dataLength; i++) {
+      int datum = data->data[i];
+      if (datum < 0) {
+        extent = max(extent, abs(-datum - offset - cullY));
+      } else {
+        extent = max(extent, abs(datum - offset - cullX) + pixelsPerData);
+        i += wordInts;
+      }
+    }
+    return extent;
+  }
+
   void set(Data* data, int x, int y, byte value) {
     if (value) {
       //Serial.printf("set %d %d %d %d\n", x, y, value, dataLength);
-      if (y == data->yCurrent) {
-        if (x < data->xCurrent) {
-          // todo: something
-        } else if (x - data->xCurrent < pixelsPerData) {
-          data->data[data->dataLength - 1] |= value << (bitsPerPixel * (x - data->xCurrent));
-        } else {
-          data->data[data->dataLength++] = x + offset;
-          data->data[data->dataLength++] = value;
-          data->xCurrent = x;
-        }
-      } else if (y > data->yCurrent) {
-        data->data[data->dataLength++] = -(y + offset);
+      if (abs(x - cullX) > cullRadius || abs(y - cullY) > cullRadius) {
+        data->culled++;
+        return;
+      }
+      switch (bitsPerPixel) {
+        case 1:
+          append<1>(data, x, y, value);
+          break;
+        case 2:
+          append<2>(data, x, y, value);
+          break;
+        case 4:
+          append<4>(data, x, y, value);
+          break;
+        default:
+          append<8>(data, x, y, value);
+      }
+    }
+  }
+
+  // Set the cells from (x, y) to (x + length - 1, y), checking the cull radius
+  // once for the whole run if we can
+  template <int bits>
+  void setRun(Data* data, int x, int y, const byte* values, int length) {
+    if (abs(y - cullY) > cullRadius || abs(x - cullX) > cullRadius || abs(x + length - 1 - cullX) > cullRadius) {
+      for (int i = 0; i < length; i++) set(data, x + i, y, values[i]);
+      return;
+    }
+    for (int i = 0; i < length; i++) {
+      if (values[i]) append<bits>(data, x + i, y, values[i]);
+    }
+  }
+
+  // Append a run of length cells of value. The first cell of each word goes
+  // through append, which starts the word, then the rest are or'ed in at once.
+  template <int bits>
+  void fill(Data* data, int x, int y, int length, byte value) {
+    const int cellsPerWord = 64 / bits;
+    // value repeated in every cell of a word
+    Word pattern = value * (~(Word)0 / ((1 << bits) - 1));
+    int end = x + length;
+    while (x < end) {
+      append<bits>(data, x, y, value);
+      int first = x - data->xCurrent;
+      if (y != data->yCurrent || first < 0 || first >= cellsPerWord) {
+        // It didn't fit
+        x++;
+        continue;
+      }
+      int n = min(end - x, cellsPerWord - first);
+      Word run = n == cellsPerWord ? pattern : (pattern & (((Word)1 << (bits * n)) - 1)) << (bits * first);
+      data->data[data->dataLength - wordInts] |= (uint32_t)run;
+      data->data[data->dataLength - wordInts + 1] |= (uint32_t)(run >> 32);
+      x += n;
+    }
+  }
+
+  // Add a live cell after those already in data. A cell never straddles the
+  // two halves of a word, so it is or'ed straight into the one it belongs in.
+  template <int bits>
+  void append(Data* data, int x, int y, byte value) {
+    if (y == data->yCurrent) {
+      if (x < data->xCurrent) {
+        // todo: something
+      } else if (x - data->xCurrent < 64 / bits) {
+        int shift = bits * (x - data->xCurrent);
+        data->data[data->dataLength - wordInts + (shift >> 5)] |= (uint32_t)value << (shift & 31);
+      } else if (!data->reserve(1 + wordInts)) {
+        data->culled++;
+      } else {
         data->data[data->dataLength++] = x + offset;
         data->data[data->dataLength++] = value;
-        data->yCurrent = y;
+        data->data[data->dataLength++] = 0;
         data->xCurrent = x;
-      } else {
-        // todo: something
       }
+    } else if (y > data->yCurrent) {
+      if (!data->reserve(2 + wordInts)) {
+        data->culled++;
+        return;
+      }
+      data->data[data->dataLength++] = -(y + offset);
+      data->data[data->dataLength++] = x + offset;
+      data->data[data->dataLength++] = value;
+      data->data[data->dataLength++] = 0;
+      data->yCurrent = y;
+      data->xCurrent = x;
+    } else {
+      // todo: something
     }
   }
 
-  static int min3(int x, int y, int z) {
-    return min(min(x, y), z);
-  }
   byte bitsPerPixel;
   byte pixelsPerData;
   int mask;
@@ -851,6 +1742,28 @@ private:
   Data* data;
   Data* next;
   TreeRule* treeRule;
+  CompiledRule compiledRule;
+  int cullX = 32;
+  int cullY = 32;
+  int cullRadius = INT_MAX;
+  int culledCells = 0;
+  const static int minCullRadius = 64;
+  const static int maxRun = 128;
+  // True if next holds the generation before data
+  bool hasPrevious = false;
+  // Hash of data, if hashValid
+  uint64_t hash = 0;
+  bool hashValid = true;
+  // Tiles are 16x16 cells
+  const static int tileShift = 4;
+  TileSet activeTiles;
+  TileSet activeRows;
+  bool activeAll = true;
+#ifndef ARDUINO
+  const static int minParallelLength = 4096;
+  ThreadPool* threadPool = 0;
+  std::vector<std::unique_ptr<Data>> bands;
+#endif
   const static int offset = 100000;
 };
 
@@ -862,6 +1775,7 @@ public:
     data2 = (byte*)malloc(sizeof(byte) * w * h);
     data = data1;
     next = data2;
+    compiledRule.compile(0, treeRule);
     clear();
   }
   ~SimpleLife() {
@@ -870,11 +1784,15 @@ public:
   }
   virtual void setRule(int nStates, TreeRule* rule) {
     this->treeRule = rule;
+    compiledRule.compile(nStates, rule);
     clear();
   }
   // methods
   void clear() {
     memset(data, 0, sizeof(byte) * width * height);
+    hasPrevious = false;
+    hash = 0;
+    hashValid = true;
   }
   byte get(int x, int y) {
     if (x < 0 || x >= width) return 0;
@@ -885,20 +1803,77 @@ public:
     if (x < 0 || x >= width) return;
     if (y < 0 || y >= height) return;
     data[x + y * width] = value;
+    hasPrevious = false;
+    hashValid = false;
   }
   void nextGeneration() {
-    iterateNeighborhood([this](int x, int y, int* neighbors) {
+    auto update = [this](uint64_t& hashDelta, int x, int y, int* neighbors) {
       //if (neighbors[0] + neighbors[1] + neighbors[2] + neighbors[3] + neighbors[4] + neighbors[5] + neighbors[6] + neighbors[7] + neighbors[8] > 0) {
       //  Serial.printf("x=%d y=%d, [%d,%d,%d,%d,%d,%d,%d,%d,%d]\n", x, y, neighbors[0], neighbors[1], neighbors[2], neighbors[3], neighbors[4], neighbors[5], neighbors[6], neighbors[7], neighbors[8]);
       //}
-      next[x + y * width] = treeRule->transition(neighbors);
+      int value = compiledRule.transition(neighbors);
+      if (value != neighbors[8]) hashDelta += cellHash(x, y, value) - cellHash(x, y, neighbors[8]);
+      next[x + y * width] = value;
+    };
+#ifndef ARDUINO
+    if (threadPool) {
+      // Each band of rows only writes its own rows of next
+      int nBands = min(threadPool->getThreads() * 4, height);
+      std::vector<uint64_t> deltas(nBands);
+      threadPool->parallelFor(nBands, [&](int b) {
+        iterateNeighborhood([&](int x, int y, int* neighbors) {
+          update(deltas[b], x, y, neighbors);
+        }, height * b / nBands, height * (b + 1) / nBands);
+      });
+      for (uint64_t delta : deltas) hash += delta;
+    } else {
+      iterateNeighborhood([&](int x, int y, int* neighbors) {
+        update(hash, x, y, neighbors);
+      });
+    }
+#else
+    iterateNeighborhood([&](int x, int y, int* neighbors) {
+      update(hash, x, y, neighbors);
     });
+#endif
     byte* temp = data;
     data = next;
     next = temp;
+    hasPrevious = true;
   }
-  void iterateNeighborhood(std::function<void(int x, int y, int* neighbors)> lambda) {
+  // The previous generation is still in next
+  bool iterateChanged(std::function<void(int x, int y, int value)> lambda) {
+    if (!hasPrevious) return false;
     for (int y = 0; y < height; y++) {
+      const byte* row = data + y * width;
+      const byte* previous = next + y * width;
+      if (!memcmp(row, previous, width)) continue;
+      for (int x = 0; x < width; x++) {
+        if (row[x] != previous[x]) lambda(x, y, row[x]);
+      }
+    }
+    return true;
+  }
+  uint64_t getHash() {
+    if (!hashValid) {
+      hash = Life::getHash();
+      hashValid = true;
+    }
+    return hash;
+  }
+  size_t getStateBytes() {
+    return 2 * sizeof(byte) * width * height;
+  }
+#ifndef ARDUINO
+  // Step in parallel bands on the given pool (or serially if 0)
+  void setThreadPool(ThreadPool* pool) {
+    threadPool = pool;
+  }
+#endif
+  template <class F>
+  void iterateNeighborhood(F&& lambda, int yStart = 0, int yEnd = INT_MAX) {
+    yEnd = min(yEnd, height);
+    for (int y = yStart; y < yEnd; y++) {
       for (int x = 0; x < width; x++) {
         int neighbors[] = {
           get(x - 1, y - 1), get(x, y - 1), get(x + 1, y - 1),
@@ -910,13 +1885,24 @@ public:
       }
     }
   }
-  void iterateLive(std::function<void(int x, int y, int value)> lambda) {
-    for (int x = 0; x < width; x++) {
-      for (int y = 0; y < height; y++) {
-        byte v = get(x, y);
-        if (v != 0) {
-          lambda(x, y, get(x, y));
-        }
+  void iterateLiveRuns(RunVisitor& visitor) {
+    forEachLiveRun([&visitor](int x, int y, int length, const byte* values) {
+      visitor.visit(x, y, length, values);
+    });
+  }
+  // Each row is one span, straight out of the array
+  template <class F>
+  void forEachLiveRun(F&& f) {
+    for (int y = 0; y < height; y++) {
+      f(0, y, width, data + y * width);
+    }
+  }
+  template <class F>
+  void forEachLive(F&& f) {
+    for (int y = 0; y < height; y++) {
+      const byte* row = data + y * width;
+      for (int x = 0; x < width; x++) {
+        if (row[x]) f(x, y, row[x]);
       }
     }
   }
@@ -929,5 +1915,12 @@ private:
   byte* data;
   byte* next;
   TreeRule* treeRule;
+  CompiledRule compiledRule;
+  bool hasPrevious = false;
+  uint64_t hash = 0;
+  bool hashValid = true;
+#ifndef ARDUINO
+  ThreadPool* threadPool = 0;
+#endif
 };
 #endif
\ No newline at end of file
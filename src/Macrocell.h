@@ -0,0 +1,369 @@
+#ifndef Macrocell_h
+#define Macrocell_h
+
+#include "Platform.h"
+#include "HashLife.h"
+#include "Life.h"
+
+// Golly's macrocell format (https://golly.sourceforge.io/Help/formats.html#mc),
+// which stores a pattern as its quadtree with identical nodes written once.
+// After the "[M2]" line and any # lines (#R gives the rule, #G the
+// generation), each line is a node, numbered from 1. Two state patterns have
+// 8x8 leaves written as rows of '.' and '*', each ending in '$'. Every other
+// line is "level nw ne sw se", where the children are earlier line numbers,
+// or 0 for an empty node. Multi-state patterns have no 8x8 leaves: their level
+// 1 nodes give the four cell states directly.
+//
+// The root's center is at (0, 0), as in HashLife. Loading into a HashLife
+// builds its quadtree directly, so takes time in proportion to the number of
+// lines rather than cells. Any other engine is given the cells a row at a time.
+//
+//   MacrocellReader reader;
+//   if (reader.parse(text, end, nStates)) reader.load(hashLife);
+
+struct MacrocellHeader {
+  const static int maxRuleLength = 64;
+  char rule[maxRuleLength] = "";
+  unsigned long long generation = 0;
+};
+
+// Read a # line into header
+inline void readMacrocellComment(const char* line, const char* lineEnd, MacrocellHeader& header) {
+  if (lineEnd - line < 2) return;
+  const char* c = line + 2;
+  while (c < lineEnd && *c == ' ') c++;
+  if (line[1] == 'R') {
+    int n = 0;
+    while (c < lineEnd && *c != ' ' && *c != '\r' && n < MacrocellHeader::maxRuleLength - 1) header.rule[n++] = *c++;
+    header.rule[n] = 0;
+  } else if (line[1] == 'G') {
+    header.generation = 0;
+    while (c < lineEnd && *c >= '0' && *c <= '9') header.generation = header.generation * 10 + *c++ - '0';
+  }
+}
+
+// Read just the header, for choosing the rule before the pattern is parsed
+inline void parseMacrocellHeader(const char* p, const char* end, MacrocellHeader& header) {
+  while (p < end && (*p == '#' || *p == '[' || *p == '\r' || *p == '\n')) {
+    const char* line = p;
+    while (p < end && *p != '\n') p++;
+    if (*line == '#') readMacrocellComment(line, p, header);
+    if (p < end) p++;
+  }
+}
+
+class MacrocellReader {
+public:
+  ~MacrocellReader() {
+    free(nodes);
+    free(strip);
+  }
+  // Returns false if text isn't a macrocell pattern for at most nStates
+  // states. Cells marked '*' in 8x8 leaves get the state on.
+  bool parse(const char* text, const char* end, int nStates, byte on = 1, MacrocellHeader* header = 0) {
+    if (on == 0 || on >= nStates || !reserve(1)) return false;
+    nNodes = 1;
+    memset(nodes, 0, sizeof(Node));
+    const char* p = text;
+    while (p < end) {
+      const char* line = p;
+      while (p < end && *p != '\n') p++;
+      const char* lineEnd = p;
+      if (p < end) p++;
+      if (lineEnd > line && lineEnd[-1] == '\r') lineEnd--;
+      if (line == lineEnd || *line == '[') continue;
+      if (*line == '#') {
+        if (header) readMacrocellComment(line, lineEnd, *header);
+        continue;
+      }
+      if (!reserve(nNodes + 1)) return false;
+      Node& node = nodes[nNodes];
+      bool ok = *line == '.' || *line == '*' || *line == '$' ? readLeaf(line, lineEnd, on, node)
+                                                              : readNode(line, lineEnd, nStates, node);
+      if (!ok) return false;
+      nNodes++;
+    }
+    return nNodes > 1;
+  }
+
+  // Build the pattern in life's quadtree, replacing what was there
+  void load(HashLife& life) {
+    life.clear();
+    uint32_t* map = (uint32_t*)malloc(sizeof(uint32_t) * nNodes);
+    assert(map);
+    for (int i = 1; i < nNodes; i++) {
+      const Node& node = nodes[i];
+      if (node.leaf) {
+        map[i] = leafNode(life, node, 0, 0, 3);
+        continue;
+      }
+      uint32_t c[4];
+      for (int q = 0; q < 4; q++) {
+        uint32_t child = node.children[q];
+        c[q] = node.level == 1 ? child : child ? map[child] : life.emptyNode(node.level - 1);
+      }
+      map[i] = life.makeNode(c[0], c[1], c[2], c[3]);
+    }
+    life.setRoot(map[nNodes - 1]);
+    free(map);
+  }
+
+  // Set the cells in any engine, in increasing y and x, moved by (xOff, yOff).
+  // Empty parts of the tree are skipped whole.
+  void load(Life& life, int xOff, int yOff) {
+    life.clear();
+    const Node& root = nodes[nNodes - 1];
+    long long half = 1LL << (root.level - 1);
+    if (!reserveStrip(1)) return;
+    strip[0].n = nNodes - 1;
+    strip[0].x = xOff - half;
+    stripLength = 1;
+    runLength = 0;
+    flatten(life, 0, 1, root.level, yOff - half);
+    flush(life);
+  }
+
+  int getLevel() {
+    return nodes[nNodes - 1].level;
+  }
+  // The lines in the file, one for each distinct node
+  int getNodeCount() {
+    return nNodes - 1;
+  }
+
+private:
+  struct Node {
+    byte level;
+    bool leaf;
+    // The state of the cells in an 8x8 leaf
+    byte on;
+    union {
+      // Line numbers, or for level 1 nodes the states
+      uint32_t children[4];
+      // The cells of an 8x8 leaf, bit x of rows[y]
+      byte rows[8];
+    };
+  };
+  // A node in a horizontal strip, with its left edge
+  struct StripNode {
+    uint32_t n;
+    long long x;
+  };
+
+  bool reserve(int n) {
+    if (n <= nAlloc) return true;
+    int newAlloc = max(n, nAlloc * 2);
+    Node* grown = (Node*)realloc(nodes, sizeof(Node) * newAlloc);
+    if (!grown) return false;
+    nodes = grown;
+    nAlloc = newAlloc;
+    return true;
+  }
+
+  bool reserveStrip(int n) {
+    if (n <= stripAlloc) return true;
+    int newAlloc = max(n, stripAlloc * 2);
+    StripNode* grown = (StripNode*)realloc(strip, sizeof(StripNode) * newAlloc);
+    if (!grown) return false;
+    strip = grown;
+    stripAlloc = newAlloc;
+    return true;
+  }
+
+  static bool readLeaf(const char* c, const char* lineEnd, byte on, Node& node) {
+    node.level = 3;
+    node.leaf = true;
+    node.on = on;
+    memset(node.rows, 0, sizeof(node.rows));
+    int x = 0, y = 0;
+    for (; c < lineEnd; c++) {
+      if (*c == '$') {
+        x = 0;
+        y++;
+      } else if (x >= 8 || y >= 8 || (*c != '*' && *c != '.')) {
+        return false;
+      } else {
+        if (*c == '*') node.rows[y] |= 1 << x;
+        x++;
+      }
+    }
+    return true;
+  }
+
+  bool readNode(const char* c, const char* lineEnd, int nStates, Node& node) {
+    uint32_t values[5];
+    for (int i = 0; i < 5; i++) {
+      while (c < lineEnd && *c == ' ') c++;
+      if (c == lineEnd || *c < '0' || *c > '9') return false;
+      uint32_t value = 0;
+      while (c < lineEnd && *c >= '0' && *c <= '9') value = value * 10 + *c++ - '0';
+      values[i] = value;
+    }
+    int level = values[0];
+    if (level < 1 || level > 62) return false;
+    node.level = level;
+    node.leaf = false;
+    for (int i = 0; i < 4; i++) {
+      uint32_t child = values[i + 1];
+      bool ok = level == 1 ? child < (uint32_t)nStates
+                           : child == 0 || (child < (uint32_t)nNodes && nodes[child].level == level - 1);
+      if (!ok) return false;
+      node.children[i] = child;
+    }
+    return true;
+  }
+
+  // The HashLife node for the 2^level square of an 8x8 leaf at (x, y) in it
+  uint32_t leafNode(HashLife& life, const Node& leaf, int x, int y, int level) {
+    if (level == 0) return leaf.rows[y] >> x & 1 ? leaf.on : 0;
+    int h = 1 << (level - 1);
+    return life.makeNode(leafNode(life, leaf, x, y, level - 1), leafNode(life, leaf, x + h, y, level - 1),
+                         leafNode(life, leaf, x, y + h, level - 1), leafNode(life, leaf, x + h, y + h, level - 1));
+  }
+
+  // Set the cells of strip[begin] to strip[end - 1], nodes at the given level
+  // with their top edge at y, from left to right. The strips for the top and
+  // bottom halves are built after end, without their empty nodes.
+  void flatten(Life& life, int begin, int end, int level, long long y) {
+    if (nodes[strip[begin].n].leaf) {
+      for (int row = 0; row < 8; row++) {
+        for (int i = begin; i < end; i++) {
+          const Node& leaf = nodes[strip[i].n];
+          for (int bits = leaf.rows[row]; bits; bits &= bits - 1) {
+            cell(life, strip[i].x + __builtin_ctz(bits), y + row, leaf.on);
+          }
+        }
+      }
+      return;
+    }
+    if (level == 1) {
+      for (int row = 0; row < 2; row++) {
+        for (int i = begin; i < end; i++) {
+          const Node& node = nodes[strip[i].n];
+          for (int column = 0; column < 2; column++) {
+            byte value = node.children[row * 2 + column];
+            if (value) cell(life, strip[i].x + column, y + row, value);
+          }
+        }
+      }
+      return;
+    }
+    long long h = 1LL << (level - 1);
+    for (int half = 0; half < 2; half++) {
+      int start = end;
+      stripLength = end;
+      for (int i = begin; i < end; i++) {
+        if (!reserveStrip(stripLength + 2)) return;
+        const Node& node = nodes[strip[i].n];
+        long long x = strip[i].x;
+        uint32_t left = node.children[half * 2];
+        uint32_t right = node.children[half * 2 + 1];
+        if (left) strip[stripLength++] = { left, x };
+        if (right) strip[stripLength++] = { right, x + h };
+      }
+      if (stripLength > start) flatten(life, start, stripLength, level - 1, y + half * h);
+    }
+    stripLength = end;
+  }
+
+  // Cells come in order, and are passed on as runs of the same state
+  void cell(Life& life, long long x, long long y, byte value) {
+    if (runLength && (y != runY || x != runX + runLength || value != runValue)) flush(life);
+    if (!runLength) {
+      runX = x;
+      runY = y;
+      runValue = value;
+    }
+    runLength++;
+  }
+  void flush(Life& life) {
+    if (runLength) life.setRun(runX, runY, runLength, runValue);
+    runLength = 0;
+  }
+
+  Node* nodes = 0;
+  int nNodes = 0;
+  int nAlloc = 0;
+  StripNode* strip = 0;
+  int stripLength = 0;
+  int stripAlloc = 0;
+  long long runX = 0;
+  long long runY = 0;
+  int runLength = 0;
+  byte runValue = 0;
+};
+
+#ifndef ARDUINO
+// Write the universe of life to out in macrocell format. Two state rules get
+// 8x8 leaves, as Golly writes them. Returns false if the write failed.
+inline bool writeMacrocell(HashLife& life, FILE* out, const char* rule = 0) {
+  class Writer {
+  public:
+    Writer(HashLife& life, FILE* out)
+      : life(life), out(out) {
+      // Make every empty node now, so none are added while numbering
+      int rootLevel = life.getLevel(life.getRoot());
+      for (int level = 0; level <= rootLevel; level++) life.emptyNode(level);
+      lines = (uint32_t*)calloc(life.getNodeCount(), sizeof(uint32_t));
+      assert(lines);
+    }
+    ~Writer() {
+      free(lines);
+    }
+    // The line number of node n, writing it and its children first if need be
+    uint32_t write(uint32_t n) {
+      int level = life.getLevel(n);
+      if (n == life.emptyNode(level)) return 0;
+      if (lines[n]) return lines[n];
+      uint32_t c[4];
+      life.getChildren(n, c);
+      if (level == 3 && life.getNStates() == 2) {
+        byte rows[8] = {};
+        leafRows(n, 3, 0, 0, rows);
+        int last = 7;
+        while (rows[last] == 0) last--;
+        for (int y = 0; y <= last; y++) {
+          for (int x = 0; rows[y] >> x; x++) fputc(rows[y] >> x & 1 ? '*' : '.', out);
+          fputc('$', out);
+        }
+        fputc('\n', out);
+      } else if (level == 1) {
+        fprintf(out, "1 %u %u %u %u\n", c[0], c[1], c[2], c[3]);
+      } else {
+        uint32_t l[4];
+        for (int q = 0; q < 4; q++) l[q] = write(c[q]);
+        fprintf(out, "%d %u %u %u %u\n", level, l[0], l[1], l[2], l[3]);
+      }
+      return lines[n] = ++nLines;
+    }
+
+  private:
+    void leafRows(uint32_t n, int level, int x, int y, byte rows[8]) {
+      if (level == 0) {
+        if (n) rows[y] |= 1 << x;
+        return;
+      }
+      uint32_t c[4];
+      life.getChildren(n, c);
+      int h = 1 << (level - 1);
+      leafRows(c[0], level - 1, x, y, rows);
+      leafRows(c[1], level - 1, x + h, y, rows);
+      leafRows(c[2], level - 1, x, y + h, rows);
+      leafRows(c[3], level - 1, x + h, y + h, rows);
+    }
+    HashLife& life;
+    FILE* out;
+    uint32_t* lines;
+    uint32_t nLines = 0;
+  };
+
+  fprintf(out, "[M2] (ColorLife)\n");
+  if (rule) fprintf(out, "#R %s\n", rule);
+  if (life.getGeneration()) fprintf(out, "#G %llu\n", life.getGeneration());
+  Writer writer(life, out);
+  writer.write(life.getRoot());
+  return !ferror(out);
+}
+#endif
+
+#endif
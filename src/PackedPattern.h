@@ -0,0 +1,92 @@
+#ifndef PackedPattern_h
+#define PackedPattern_h
+
+#include "Platform.h"
+#include "Life.h"
+#include "Random.h"
+
+// Patterns compiled ahead of time from RLE (see host/PatternCompiler.cpp)
+// into the rows InfiniteLife keeps, so starting one is a block copy rather
+// than parsing text. The compiled catalog is PatternCatalog.h.
+
+// Rules the patterns run under
+enum PatternRule {
+  PatternNiemiec,       // B3/S23, NiemiecTreeRule, 9 states
+  PatternGenerations,   // 12345/45678/8, GenerationsTreeRule
+  PatternGenerations1   // 345/2/4, Generations1TreeRule
+};
+
+inline TreeRule* patternTreeRule(PatternRule rule, int& nStates) {
+  static NiemiecTreeRule niemiec;
+  static GenerationsTreeRule generations;
+  static Generations1TreeRule generations1;
+  switch (rule) {
+    case PatternGenerations:
+      nStates = 8;
+      return &generations;
+    case PatternGenerations1:
+      nStates = 4;
+      return &generations1;
+    default:
+      nStates = 9;
+      return &niemiec;
+  }
+}
+
+// How the matrix shows a pattern
+struct PatternDisplay {
+  // 0xRRGGBB for states 0 to nColors - 1, or 0 for the default colours
+  const uint32_t* palette = 0;
+  int nColors = 0;
+  // Top left corner on the matrix, or -1 to center it
+  int left = -1;
+  int top = -1;
+  // Viewport motion, see LEDMatrixLife::setViewportSpeed
+  int speedX = 0;
+  int speedY = 0;
+  int speedDivisor = 0;
+  int initialDelay = 0;
+  // Chance of start() picking it, relative to the other patterns
+  int weight = 1;
+};
+
+struct PackedPattern {
+  const char* name;
+  PatternRule rule;
+  int width;
+  int height;
+  // Bits per cell, InfiniteLife::bitsPerCell for the rule's states
+  int bits;
+  // Rows as Life::setPacked takes them, with the top left corner at (0, 0)
+  const int* rows;
+  int length;
+  // Whether the rows hold cells of the all ones value, marking the RLE's 'o'
+  // cells to be given random colours each time the pattern is loaded
+  bool randomColours;
+  PatternDisplay display;
+};
+
+// Load pattern into life with its top left corner at (xOff, yOff), picking the
+// colours of its 'o' cells with rng. life should already have the pattern's
+// rule.
+inline void loadPackedPattern(Life& life, int xOff, int yOff, const PackedPattern& pattern, LifeRandom& rng) {
+  int nStates;
+  patternTreeRule(pattern.rule, nStates);
+  life.clear();
+  life.setPacked(xOff, yOff, pattern.rows, pattern.length, pattern.bits, pattern.randomColours ? &rng : 0, nStates);
+}
+
+// One of the n patterns in catalog, picked at random by weight
+inline const PackedPattern* pickPattern(const PackedPattern* const* catalog, int n, LifeRandom& rng) {
+  long total = 0;
+  for (int i = 0; i < n; i++) total += catalog[i]->display.weight;
+  if (total <= 0) return 0;
+  long r = rng.random(total);
+  for (int i = 0; i < n; i++) {
+    r -= catalog[i]->display.weight;
+    if (r < 0) return catalog[i];
+  }
+  return 0;
+}
+
+#endif
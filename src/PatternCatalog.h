@@ -0,0 +1,440 @@
+#ifndef PatternCatalog_h
+#define PatternCatalog_h
+
+// Generated by host/PatternCompiler.cpp, do not edit
+
+#include "PackedPattern.h"
+
+// Lava, 63 x 63
+const int lavaRows[] = {
+  -1, 0, 0x11111111, 0x11111111, 16, 0x11111111, 0x11111111, 32, 0x11111111, 0x11111111,
+    48, 0x11111111, 0x1111111,
+  -2, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -3, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -4, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -5, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -6, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -7, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -8, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -9, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -10, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -11, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -12, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -13, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -14, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -15, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -16, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -17, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -18, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -19, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -20, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -21, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -22, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -23, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -24, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -25, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -26, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -27, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -28, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -29, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -30, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -31, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -32, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -33, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -34, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -35, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -36, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -37, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -38, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -39, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -40, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -41, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -42, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -43, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -44, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -45, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -46, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -47, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -48, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -49, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -50, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -51, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -52, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -53, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -54, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -55, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -56, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -57, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -58, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -59, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -60, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -61, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -62, 0, 0x1, 0x0, 62, 0x1, 0x0,
+  -63, 0, 0x11111111, 0x11111111, 16, 0x11111111, 0x11111111, 32, 0x11111111, 0x11111111,
+    48, 0x11111111, 0x1111111,
+};
+const uint32_t lavaPalette[] = { 0x000000, 0xff0000, 0xff2a00, 0xff5400, 0xff7e00, 0xffa800, 0xffd200, 0xfffe00 };
+const PackedPattern lavaPacked = { "Lava", PatternGenerations, 63, 63, 4, lavaRows, 453, false,
+  { lavaPalette, 8, -1, -1, 0, 0, 0, 0, 1 } };
+
+// SteepleChase, 63 x 59
+const int steeplechaseRows[] = {
+  -3, 31, 0x1, 0x0,
+  -4, 30, 0x10400015, 0x0,
+  -5, 31, 0x15540001, 0x0,
+  -6, 31, 0x4100001, 0x0,
+  -7, 30, 0x10400015, 0x0,
+  -8, 31, 0x15540001, 0x0,
+  -9, 31, 0x4100001, 0x0,
+  -10, 30, 0x10400015, 0x0,
+  -11, 31, 0x15540001, 0x0,
+  -12, 5, 0xb, 0x100000, 41, 0x41, 0x0,
+  -13, 7, 0x3, 0x54000, 41, 0x41, 0x0,
+  -14, 4, 0x211, 0x400000, 40, 0x555, 0xb,
+  -15, 1, 0x5551, 0x10000000, 41, 0x40000041, 0x4,
+  -16, 1, 0x4416, 0x54000040, 41, 0x50000041, 0x1,
+  -17, 1, 0x2c63, 0x10000150, 40, 0x555, 0x1,
+  -18, 20, 0x400001, 0x10400,
+  -19, 20, 0x1500001, 0x0,
+  -20, 19, 0x1000015, 0x0,
+  -21, 20, 0x400001, 0x0,
+  -22, 20, 0x1500001, 0x0,
+  -23, 19, 0x1000015, 0x0,
+  -24, 20, 0x400001, 0x0,
+  -25, 20, 0x1500001, 0x0,
+  -26, 19, 0x1000015, 0x0,
+  -27, 20, 0x1, 0x0,
+  -31, 61, 0x1, 0x0,
+  -32, 60, 0x15, 0x0,
+  -33, 48, 0x4000001, 0x0,
+  -34, 16, 0x401, 0x40000400, 48, 0x4000005, 0x0,
+  -35, 2, 0x54000001, 0x150, 36, 0x14500015, 0x140000,
+  -36, 1, 0x40000015, 0x114, 35, 0x44500145, 0x100001,
+  -37, 2, 0x10000001, 0x45, 34, 0x45001445, 0x400014,
+  -38, 1, 0x50000039, 0x541, 33, 0x50001445, 0x5000014,
+  -39, 16, 0x401, 0x1450, 48, 0x4000015, 0x0,
+  -40, 35, 0x10000015, 0x100000,
+  -41, 36, 0x1, 0x150000,
+  -42, 61, 0x1, 0x0,
+  -52, 14, 0x100401, 0x100040, 50, 0x1, 0x0,
+  -53, 13, 0x1505415, 0x1500540, 49, 0x15, 0x0,
+  -54, 14, 0x114451, 0x100040, 50, 0xc4001, 0x0,
+  -55, 3, 0x14400001, 0x10000451, 40, 0x100001, 0x95,
+  -56, 2, 0x5400015, 0x50005415, 34, 0x40005401, 0x44005,
+  -57, 3, 0x400001, 0x10000401, 40, 0x100001, 0x0,
+  -58, 2, 0x39, 0x0,
+};
+const uint32_t steeplechasePalette[] = { 0x000000, 0xff0000, 0xff8000, 0xffff00 };
+const PackedPattern steeplechasePacked = { "SteepleChase", PatternGenerations1, 63, 59, 2, steeplechaseRows, 230, false,
+  { steeplechasePalette, 4, -1, -1, 0, 0, 0, 0, 1 } };
+
+// p107 R-pentomino hassler, 51 x 30
+const int p107RPentominoHasslerRows[] = {
+  -1, 6, 0xf, 0x0,
+  -2, 6, 0xfff, 0x0,
+  -3, 9, 0xf, 0x0,
+  -4, 8, 0xff, 0x0, 42, 0xff, 0x0,
+  -5, 42, 0xff, 0x0,
+  -7, 1, 0xff, 0x0, 32, 0xff, 0x0,
+  -8, 1, 0xf, 0x0, 32, 0xf, 0x0, 49, 0xff, 0x0,
+  -9, 2, 0xfff, 0x0, 30, 0xf0f, 0x0, 49, 0xf, 0x0,
+  -10, 4, 0xf, 0x0, 30, 0xff, 0x0, 47, 0xf0f, 0x0,
+  -11, 47, 0xff, 0x0,
+  -12, 10, 0xff, 0x0,
+  -13, 0, 0xff, 0xf00f0,
+  -14, 0, 0xff, 0xff0ff,
+  -15, 10, 0xf, 0x0,
+  -16, 40, 0xf, 0x0,
+  -17, 38, 0xff0ff, 0xff000,
+  -18, 38, 0xf00f, 0xff000,
+  -19, 39, 0xff, 0x0,
+  -20, 2, 0xff, 0x0,
+  -21, 1, 0xf0f, 0x0, 19, 0xff, 0x0, 46, 0xf, 0x0,
+  -22, 1, 0xf, 0x0, 18, 0xf0f, 0x0, 46, 0xfff, 0x0,
+  -23, 0, 0xff, 0x0, 18, 0xf, 0x0, 49, 0xf, 0x0,
+  -24, 17, 0xff, 0x0, 48, 0xff, 0x0,
+  -26, 7, 0xff, 0x0,
+  -27, 7, 0xff, 0x0, 41, 0xff, 0x0,
+  -28, 41, 0xf, 0x0,
+  -29, 42, 0xfff, 0x0,
+  -30, 44, 0xf, 0x0,
+};
+const PackedPattern p107RPentominoHasslerPacked = { "p107 R-pentomino hassler", PatternNiemiec, 51, 30, 4, p107RPentominoHasslerRows, 160, true,
+  { 0, 0, -1, -1, 0, 0, 0, 0, 1 } };
+
+// ASJ 2023, 30 x 22
+const int asj2023Rows[] = {
+  -1, 6, 0x30000022, 0x333, 22, 0x11111, 0x0,
+  -2, 5, 0x30002002, 0x30000, 24, 0x1, 0x0,
+  -3, 4, 0x200002, 0x3, 24, 0x1, 0x0,
+  -4, 4, 0x200002, 0x3, 24, 0x1, 0x0,
+  -5, 4, 0x200002, 0x33330, 24, 0x1, 0x0,
+  -6, 4, 0x222222, 0x300000, 24, 0x1, 0x0,
+  -7, 4, 0x200002, 0x300000, 24, 0x1, 0x0,
+  -8, 4, 0x200002, 0x300003, 20, 0x10001, 0x0,
+  -9, 4, 0x200002, 0x33330, 21, 0x111, 0x0,
+  -14, 1, 0x4444, 0x550, 17, 0x70006666, 0x77777,
+  -15, 0, 0x400004, 0x50050, 16, 0x600006, 0x700000,
+  -16, 0, 0x400004, 0x500005, 16, 0x600006, 0x70000,
+  -17, 5, 0x5004, 0x5, 21, 0x7000006, 0x0,
+  -18, 4, 0x50004, 0x50, 20, 0x77000006, 0x7,
+  -19, 2, 0x5000044, 0x5000, 18, 0x66, 0x7000,
+  -20, 1, 0x50000004, 0x50000, 17, 0x6, 0x70000,
+  -21, 0, 0x4, 0x50050, 16, 0x6, 0x700007,
+  -22, 0, 0x444444, 0x5500, 16, 0x666666, 0x77770,
+};
+const PackedPattern asj2023Packed = { "ASJ 2023", PatternNiemiec, 30, 22, 4, asj2023Rows, 126, false,
+  { 0, 0, -1, -1, 0, 0, 0, 1000, 0 } };
+
+// Snark catalyst variants, 51 x 52
+const int snarkCatalystVariantsRows[] = {
+  -1, 20, 0x11, 0x0,
+  -2, 20, 0x101, 0x0,
+  -3, 22, 0x1100001, 0x0,
+  -4, 18, 0x1101111, 0x10010,
+  -5, 18, 0x10101001, 0x11010,
+  -6, 21, 0x1010101, 0x0,
+  -7, 22, 0x101011, 0x0,
+  -8, 26, 0x1, 0x0,
+  -10, 12, 0x11, 0x0,
+  -11, 13, 0x1, 0x11,
+  -12, 13, 0x101, 0x11,
+  -13, 14, 0x11, 0x0, 41, 0x2, 0x0,
+  -14, 39, 0x222, 0x0,
+  -15, 38, 0x2, 0x0,
+  -16, 38, 0x22, 0x0,
+  -19, 46, 0x22, 0x0,
+  -20, 24, 0x11, 0x0, 47, 0x2, 0x0,
+  -21, 24, 0x1, 0x0, 47, 0x2202, 0x0,
+  -22, 14, 0x555, 0x111000, 39, 0x22000022, 0x2002,
+  -23, 4, 0x4, 0x50000, 27, 0x1, 0x220000, 44, 0x220002, 0x0,
+  -24, 2, 0x44444, 0x500000, 21, 0x44, 0x0, 44, 0x2222, 0x0,
+  -25, 1, 0x4000004, 0x0, 21, 0x4, 0x220, 47, 0x2, 0x0,
+  -26, 1, 0x444004, 0x0, 19, 0x404, 0x20200, 44, 0x222, 0x0,
+  -27, 0, 0x4044, 0x0, 19, 0x44, 0x200, 43, 0x2, 0x0,
+  -28, 0, 0x4444004, 0x0, 28, 0x22, 0x0, 44, 0x22222, 0x0,
+  -29, 1, 0x400044, 0x440, 23, 0x3, 0x0, 46, 0x2002, 0x0,
+  -30, 3, 0x40000444, 0x4, 23, 0x333, 0x0, 48, 0x22, 0x0,
+  -31, 3, 0x4, 0x0, 26, 0x3, 0x0,
+  -32, 0, 0x4044, 0x0, 25, 0x33, 0x0,
+  -33, 0, 0x44044, 0x0,
+  -36, 11, 0x44, 0x0,
+  -37, 12, 0x4, 0x0,
+  -38, 9, 0x444, 0x0,
+  -39, 9, 0x4, 0x0, 35, 0x33, 0x0,
+  -40, 28, 0x30000033, 0x30,
+  -41, 28, 0x33, 0x30,
+  -42, 37, 0x33, 0x0,
+  -44, 24, 0x3, 0x0,
+  -45, 23, 0x330303, 0x3300,
+  -46, 23, 0x3030303, 0x30030,
+  -47, 22, 0x30303033, 0x33000,
+  -48, 23, 0x33033003, 0x33,
+  -49, 23, 0x300003, 0x30,
+  -50, 24, 0x30030333, 0x0,
+  -51, 26, 0x30303, 0x0,
+  -52, 29, 0x3, 0x0,
+};
+const PackedPattern snarkCatalystVariantsPacked = { "Snark catalyst variants", PatternNiemiec, 51, 52, 4, snarkCatalystVariantsRows, 253, false,
+  { 0, 0, -1, -1, 0, 0, 0, 0, 1 } };
+
+// Tanner's p46 gun, 31 x 44
+const int tannersP46GunRows[] = {
+  -1, 17, 0x30000022, 0x3,
+  -2, 17, 0x30000022, 0x3,
+  -13, 17, 0x2, 0x3,
+  -14, 15, 0x2202, 0x30330,
+  -15, 15, 0x30220002, 0x30003,
+  -16, 16, 0x3020002, 0x300,
+  -17, 17, 0x33000222, 0x3,
+  -27, 14, 0x1, 0x10000000,
+  -28, 13, 0x111, 0x0, 30, 0x1, 0x0,
+  -29, 12, 0x10101, 0x0, 28, 0x111, 0x0,
+  -30, 12, 0x10101, 0x0,
+  -31, 10, 0x10111011, 0x1,
+  -32, 9, 0x10101101, 0x101,
+  -33, 3, 0x1100044, 0x1000001, 19, 0x11, 0x0,
+  -34, 3, 0x11000044, 0x10100010, 19, 0x1101001, 0x0,
+  -35, 10, 0x11000111, 0x10110001,
+  -37, 2, 0x44, 0x0,
+  -38, 3, 0x4, 0x0,
+  -39, 0, 0x444, 0x0,
+  -40, 0, 0x4, 0x4000000,
+  -41, 13, 0x44040404, 0x0,
+  -42, 12, 0x4404404, 0x4,
+  -43, 12, 0x4, 0x0,
+  -44, 11, 0x44, 0x0,
+};
+const PackedPattern tannersP46GunPacked = { "Tanner's p46 gun", PatternNiemiec, 31, 44, 4, tannersP46GunRows, 108, false,
+  { 0, 0, 0, 0, 0, 0, 0, 0, 1 } };
+
+// R-pentomino, 3 x 3
+const int rPentominoRows[] = {
+  -1, 1, 0xff, 0x0,
+  -2, 0, 0xff, 0x0,
+  -3, 1, 0xf, 0x0,
+};
+const PackedPattern rPentominoPacked = { "R-pentomino", PatternNiemiec, 3, 3, 4, rPentominoRows, 12, true,
+  { 0, 0, -1, -1, 0, 0, 0, 0, 1 } };
+
+// Lobster, 26 x 26
+const int lobsterRows[] = {
+  -1, 12, 0xfff, 0x0,
+  -2, 12, 0xf, 0x0,
+  -3, 13, 0xff00f, 0x0,
+  -4, 16, 0xff, 0x0,
+  -5, 12, 0xff, 0x0,
+  -6, 13, 0xff, 0x0,
+  -7, 12, 0xf00f, 0x0,
+  -9, 14, 0xf00f, 0x0,
+  -10, 14, 0xf000f, 0x0,
+  -11, 15, 0xf0fff, 0x0,
+  -12, 20, 0xf, 0x0,
+  -13, 0, 0xf0f00ff, 0x0, 20, 0xf, 0x0,
+  -14, 0, 0xff0f0f, 0x0, 19, 0xf, 0x0,
+  -15, 0, 0xf0000f, 0xff, 23, 0xff, 0x0,
+  -16, 6, 0xf000f, (int)0xf00ff000, 22, 0xf00f, 0x0,
+  -17, 2, 0xff, (int)0xf000000f, 20, 0xf, 0x0,
+  -18, 2, 0xf0000ff, 0xff0000f,
+  -19, 9, 0xf00000f, 0xf000f00,
+  -20, 10, 0xf00f, 0xff,
+  -21, 11, 0xf000ff, 0xf0f000,
+  -22, 15, 0xf, 0xff0,
+  -23, 15, 0xf0000f, 0x0,
+  -24, 14, 0xf000f, 0x0,
+  -25, 14, (int)0xff00000f, 0x0,
+  -26, 15, 0xf00000f, 0x0,
+};
+const PackedPattern lobsterPacked = { "Lobster", PatternNiemiec, 26, 26, 4, lobsterRows, 115, true,
+  { 0, 0, -1, -1, -10, -10, 70, 0, 1 } };
+
+// Period 201 glider gun, 60 x 32
+const int period201GliderGunRows[] = {
+  -1, 17, (int)0xf000000f, 0xf,
+  -2, 17, (int)0xf0000fff, 0xf, 54, 0xff, 0x0,
+  -3, 20, 0xf, 0x0, 54, 0xff, 0x0,
+  -4, 11, 0xf, 0xff, 37, 0xfff, 0x0,
+  -5, 11, 0xfff, 0x0, 35, 0xfff0f, 0x0,
+  -6, 14, 0xf, 0x0, 34, 0xf, 0x0,
+  -7, 13, 0xff, 0x0, 33, 0xff, 0x0,
+  -8, 34, 0xff, 0x0,
+  -9, 35, 0xf, 0x0,
+  -10, 0, 0xff, 0x0,
+  -11, 1, 0xf, 0x0,
+  -12, 1, 0xf0f, 0x0,
+  -13, 2, 0xff, 0x0,
+  -20, 56, 0xff, 0x0,
+  -21, 56, 0xf0f, 0x0,
+  -22, 58, 0xf, 0x0,
+  -23, 58, 0xff, 0x0,
+  -24, 24, 0xf, 0x0,
+  -25, 24, 0xff, 0x0,
+  -26, 25, 0xff, 0x0, 45, 0xff, 0x0,
+  -27, 25, 0xf, 0x0, 45, 0xf, 0x0,
+  -28, 20, 0xf0fff, 0x0, 46, 0xfff, 0x0,
+  -29, 20, 0xfff, 0x0, 39, 0xff, 0xf0,
+  -30, 4, 0xff, 0x0, 39, 0xf, 0x0,
+  -31, 4, 0xff, 0x0, 34, (int)0xff0000ff, 0xf,
+  -32, 34, 0xff, 0xf,
+};
+const PackedPattern period201GliderGunPacked = { "Period 201 glider gun", PatternNiemiec, 60, 32, 4, period201GliderGunRows, 140, true,
+  { 0, 0, -1, -1, 0, 0, 0, 0, 1 } };
+
+// Sir Robin, 31 x 79
+const int sirRobinRows[] = {
+  -1, 4, 0xff, 0x0,
+  -2, 4, 0xf00f, 0x0,
+  -3, 4, 0xf000f, 0x0,
+  -4, 6, 0xfff, 0x0,
+  -5, 2, 0xff, 0xffff,
+  -6, 2, 0xff0f, 0xffff,
+  -7, 1, 0xf0000f, 0xfff0000,
+  -8, 2, 0xffff, 0xf000ff,
+  -9, 0, 0xf, 0xff00,
+  -10, 1, 0xf000f, 0x0,
+  -11, 6, 0xff00fff, 0xf0,
+  -12, 2, 0xff, 0xf0000f0,
+  -13, 13, 0xff0f, 0x0,
+  -14, 10, 0xff, 0xf,
+  -15, 11, (int)0xf0fff0ff, 0x0,
+  -16, 10, 0xf000ff, 0xf,
+  -17, 10, 0xff00f0f, 0x0,
+  -18, 10, (int)0xf0f0f00f, 0x0,
+  -19, 10, 0xfff, 0xf0,
+  -20, 11, 0xf0f0f, 0xf,
+  -21, 14, 0xf0f0ff, 0x0,
+  -22, 11, (int)0xf000000f, 0xff,
+  -24, 11, 0xf, 0xf00,
+  -25, 11, 0xf000f, 0xf000,
+  -26, 12, (int)0xff00000f, 0xfff,
+  -27, 12, 0xfff, 0x0,
+  -28, 16, 0xff, 0x0,
+  -29, 13, 0xf00fff, 0x0,
+  -30, 11, 0xf0fff0f, 0x0,
+  -31, 10, (int)0xf00f000f, 0x0,
+  -32, 11, 0xff0000f, 0xfff,
+  -33, 13, 0xf0ffff, 0xff00,
+  -34, 13, 0xffff0f, 0xff00,
+  -35, 19, 0xf, 0x0,
+  -36, 20, 0xff00f, 0x0,
+  -37, 20, 0xff, 0x0,
+  -38, 21, 0xfffff, 0x0,
+  -39, 25, 0xff, 0x0,
+  -40, 19, 0xfff, 0xf0,
+  -41, 20, 0xf000f0f, 0xf,
+  -42, 19, 0xf000f, 0xf,
+  -43, 19, 0xff000f, 0x0,
+  -44, 18, (int)0xf000000f, 0xfff0,
+  -45, 19, 0xf000ff, 0xff0,
+  -46, 20, 0xf00ffff, 0xf0,
+  -47, 22, 0xf000ff, 0x0,
+  -48, 21, 0xf, 0x0,
+  -49, 21, 0xf0ff, 0x0,
+  -50, 20, 0xf, 0x0,
+  -51, 19, 0xfffff, 0x0,
+  -52, 19, 0xf0000f, 0x0,
+  -53, 18, 0xfff0fff, 0x0,
+  -54, 18, 0xfffff0f, 0x0,
+  -55, 18, 0xf, 0x0,
+  -56, 20, 0xf, 0x0,
+  -57, 16, (int)0xfff0000f, 0xf,
+  -58, 20, 0xff0ffff, 0x0,
+  -59, 17, (int)0xf0000fff, 0x0,
+  -60, 24, 0xf0f, 0x0,
+  -61, 28, 0xf, 0x0,
+  -62, 24, 0xff00f, 0x0,
+  -63, 25, 0xfff, 0x0,
+  -64, 22, 0xff, 0x0,
+  -65, 21, 0xfff, 0xf,
+  -66, 24, 0xf0f00ff, 0x0,
+  -67, 21, (int)0xf0fff00f, 0xf0,
+  -68, 22, 0xf00f0ff, 0x0,
+  -69, 24, 0xff00f0f, 0x0,
+  -70, 26, 0xff, 0x0,
+  -71, 22, (int)0xf0000fff, 0x0,
+  -72, 22, (int)0xf0000fff, 0x0,
+  -73, 23, (int)0xfff000ff, 0x0,
+  -74, 24, 0xff0ff, 0x0,
+  -75, 25, 0xff, 0x0,
+  -76, 25, 0xf, 0x0,
+  -78, 24, 0xff, 0x0,
+  -79, 26, 0xf, 0x0,
+};
+const PackedPattern sirRobinPacked = { "Sir Robin", PatternNiemiec, 31, 79, 4, sirRobinRows, 308, true,
+  { 0, 0, 26, 10, -20, -40, 120, 0, 1 } };
+
+const PackedPattern* const patternCatalog[] = {
+  &lavaPacked,
+  &steeplechasePacked,
+  &p107RPentominoHasslerPacked,
+  &asj2023Packed,
+  &snarkCatalystVariantsPacked,
+  &tannersP46GunPacked,
+  &rPentominoPacked,
+  &lobsterPacked,
+  &period201GliderGunPacked,
+  &sirRobinPacked,
+};
+const int nCatalogPatterns = sizeof(patternCatalog) / sizeof(patternCatalog[0]);
+
+#endif
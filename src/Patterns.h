@@ -0,0 +1,160 @@
+#ifndef Patterns_h
+#define Patterns_h
+
+#include "PackedPattern.h"
+
+// The patterns shown on the matrix, kept apart from the display code so that
+// the host tools (see src/host) can run them too. The matrix itself shows them
+// from PatternCatalog.h, which host/PatternCompiler.cpp builds from these.
+
+struct Pattern {
+  const char* name;
+  const char* rle;
+  int width;
+  int height;
+  PatternRule rule;
+  PatternDisplay display;
+};
+
+const uint32_t lavaColors[] = { 0x000000, 0xff0000, 0xff2a00, 0xff5400, 0xff7e00, 0xffa800, 0xffd200, 0xfffe00 };
+const uint32_t steepleChaseColors[] = { 0x000000, 0xff0000, 0xff8000, 0xffff00 };
+
+// Lava rule by Mirek Wojtowicz
+// rule = 12345/45678/8:T300,300
+const Pattern lavaPattern = { "Lava", R"(
+    63A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$
+    A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A
+    $A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.
+    A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A
+    61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$
+    A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A$A61.A
+    $A61.A$A61.A$A61.A$63A!
+  )", 63, 63, PatternGenerations, { lavaColors, 8 } };
+
+// Star Wars Fun collection
+//
+// Steeplechase, p20
+//
+// Mirek Wojtowicz, May 1999
+// rule = 345/2/4:P500,500
+const Pattern steepleChasePattern = { "SteepleChase", R"(
+    2$31.A$30.3A8.A2.A$31.A8.6A$31.A9.A2.A$30.3A8.A2.A$31.A8.6A$31.A9.A2.
+    A$30.3A8.A2.A$31.A8.6A$5.CB24.A9.A2.A$7.C22.3A8.A2.A$4.A.A.B22.A8.6A
+    10.CB$.A.6A22.A9.A2.A11.A.A$.B2A2.A.A11.A9.3A8.A2.A10.3A$.C.BA.CB11.
+    3A9.A8.6A10.A$20.A10.A9.A2.A$20.A9.3A$19.3A9.A$20.A10.A$20.A9.3A$19.
+    3A9.A$20.A10.A$20.A9.3A$19.3A9.A$20.A4$61.A$60.3A$48.A12.A$16.A4.A15.
+    A9.3A11.A$2.A12.3A2.3A13.3A7.2A.2A10.2A$.3A12.A.2A.A13.2A.2A5.2A.A.2A
+    9.A$2.A13.A.2A.A12.2A.A.2A5.2A.A.2A8.A$.ABC11.3A2.3A10.2A.A.2A7.2A.2A
+    9.2A$16.A4.A12.2A.2A9.3A10.A$35.3A11.A11.A$36.A23.3A$61.A10$14.A4.A4.
+    A8.A6.A9.A$13.3A2.3A2.3A6.3A4.3A7.3A$14.A.2A.A.2A.A8.A6.A9.A6.A.C$3.A
+    10.A.2A.A.2A.A8.A6.A9.A5.3AB$2.3A8.3A2.3A2.3A6.3A4.3A7.3A5.A.A$3.A10.
+    A4.A4.A8.A6.A9.A$2.ABC!
+  )", 63, 59, PatternGenerations1, { steepleChaseColors, 4 } };
+
+//#N p107rpentominohassler.rle
+//#O Mitchell Riley, 2023
+//#C https://conwaylife.com/wiki/86P107
+//#C https://www.conwaylife.com/patterns/p107rpentominohassler.rle
+const Pattern p107rpentominoHasslerPattern = { "p107 R-pentomino hassler", R"(
+    6bo$6b3o$9bo$8b2o32b2o$42b2o2$b2o29b2o$bo30bo16b2o$2b3o25bobo16bo$4bo
+    25b2o15bobo$47b2o$10b2o$2o7bo2bo$2o6b2ob2o$10bo$40bo$38b2ob2o6b2o$38b
+    o2bo7b2o$39b2o$2b2o$bobo15b2o25bo$bo16bobo25b3o$2o16bo30bo$17b2o29b2o
+    2$7b2o$7b2o32b2o$41bo$42b3o$44bo!
+  )", 51, 30, PatternNiemiec, {} };
+
+const Pattern asj2023Pattern = { "ASJ 2023", R"(
+    6.2B5.4C5.5A$5.B2.B3.C4.C6.A$4.B4.B2.C11.A$4.B4.B2.C11.A$4.B4.B3.4C7.
+    A$4.6B7.C6.A$4.B4.B7.C6.A$4.B4.B2.C4.C2.A3.A$4.B4.B3.4C4.3A5$.4D5.2E5.
+    4F3.6G$D4.D3.E2.E3.F4.F7.G$D4.D2.E4.E2.F4.F6.G$5.D2.E4.E7.F5.G$4.D3.E
+    4.E6.F5.3G$2.2D4.E4.E4.2F9.G$.D6.E4.E3.F11.G$D8.E2.E3.F7.G4.G$6D4.2E4.
+    6F3.4G!
+    )", 30, 22, PatternNiemiec, { 0, 0, -1, -1, 0, 0, 0, 1000, 0 } };
+
+//#N snarkcatalystvariants.rle
+//#C four Snark catalyst variants
+//#C    Top:  original variant by Mike Playle
+//#C   Left:  Shannon Omick (better clearance on a diagonal)
+//#C  Right:  Heinrich Koenig (better clearance on a different diagonal)
+//#C Bottom:  Simon Ekstrom (better clearance on two diagonals)
+//#C https://conwaylife.com/wiki/Snark
+//#C https://www.conwaylife.com/patterns/snarkcatalystvariants.rle
+const Pattern snarkCatalystVariantsPattern = { "Snark catalyst variants", R"(
+    20.2A$20.A.A$22.A4.2A$18.4A.2A2.A2.A$18.A2.A.A.A.A.2A$21.A.A.A.A$22.2A
+    .A.A$26.A2$12.2A$13.A7.2A$13.A.A5.2A$14.2A25.B$39.3B$38.B$38.2B3$46.2B
+    $24.2A21.B$24.A22.B.2B$14.3E8.3A11.2B4.3B2.B$4.D11.E10.A11.2B3.B3.2B$
+    2.5D8.E5.2D21.4B$.D5.D13.D8.2B15.B$.D2.3D12.D.D7.B.B12.3B$2D.D15.2D8.
+    B13.B$D2.4D21.2B14.5B$.2D3.D3.2D11.C22.B2.B$3.3D4.2D11.3C22.2B$3.D22.
+    C$2D.D21.2C$2D.2D3$11.2D$12.D$9.3D$9.D25.2C$28.2C5.C.C$28.2C7.C$37.2C
+    2$24.C$23.C.C.2C4.2C$23.C.C.C.C2.C2.C$22.2C.C.C.C3.2C$23.C2.2C.4C$23.
+    C4.C3.C$24.3C.C2.C$26.C.C.C$29.C!
+    )", 51, 52, PatternNiemiec, {} };
+
+//#N tannersp46gun.rle
+//#C https://conwaylife.com/wiki/Tanner%27s_p46
+//#C https://www.conwaylife.com/patterns/tannersp46gun.rle
+const Pattern tannersP46GunPattern = { "Tanner's p46 gun", R"(
+    17.2B5.2C$17.2B5.2C11$17.B7.C$15.B.2B5.2C.C$15.B3.2B.2C3.C$16.B3.B.C3.
+    C$17.3B3.3C10$14.A14.A$13.3A14.A$12.A.A.A11.3A$12.A.A.A$10.2A.3A.2A$9.
+    A.2A.A.2A.A$3.2D3.2A.A5.A.2A$3.2D4.2A.A3.A.2A2.A.2A$10.3A3.3A3.2A.A2$
+    2.2D$3.D$3D$D13.D$13.D.D.D.2D$12.D.2D.2D.D$12.D$11.2D!
+    )", 31, 44, PatternNiemiec, { 0, 0, 0, 0 } };
+
+//#N R-pentomino
+//#C A methuselah with lifespan 1103.
+//#C www.conwaylife.com/wiki/index.php?title=R-pentomino
+const Pattern rPentominoPattern = { "R-pentomino", "b2o$2ob$bo!", 3, 3, PatternNiemiec, {} };
+
+//#N lobster.rle
+//#O Matthias Merzenich, 2011
+//#C https://conwaylife.com/wiki/Lobster_(spaceship)
+//#C https://www.conwaylife.com/patterns/lobster.rle
+const Pattern lobsterPattern = { "Lobster", R"(
+    12b3o$12bo$13bo2b2o$16b2o$12b2o$13b2o$12bo2bo2$14bo2bo$14bo3bo$15b3obo
+    $20bo$2o2bobo13bo$obob2o13bo$o4bo2b2o13b2o$6bo3bo6b2o2b2o2bo$2b2o6bo6b
+    o2bo$2b2o4bobo4b2o$9bo5bo3bo3bo$10bo2bo4b2o$11b2o3bo5bobo$15bo8b2o$15b
+    o4bo$14bo3bo$14bo5b2o$15bo5bo!
+    )", 26, 26, PatternNiemiec, { 0, 0, -1, -1, -10, -10, 70 } };
+
+//#N period201glidergun.rle
+//#O iNoMed, 2023
+//#C https://conwaylife.com/wiki/Period-201_glider_gun
+//#C https://www.conwaylife.com/patterns/period201glidergun.rle
+const Pattern period201GliderGunPattern = { "Period 201 glider gun", R"(
+    17bo6b2o$17b3o4b2o28b2o$20bo33b2o$11bo7b2o16b3o$11b3o21bob3o$14bo19bo$
+    13b2o18b2o$34b2o$35bo$2o$bo$bobo$2b2o7$56b2o$56bobo$58bo$58b2o$24bo$
+    24b2o$25b2o18b2o$25bo19bo$20b3obo21b3o$20b3o16b2o7bo$4b2o33bo$4b2o28b
+    2o4b3o$34b2o6bo!
+    )", 60, 32, PatternNiemiec, {} };
+
+//#N Sir Robin
+//#O Adam P. Goucher, Tom Rokicki; 2018
+//#C The first elementary knightship to be found in Conway's Game of Life.
+//#C https://conwaylife.com/wiki/Sir_Robin
+const Pattern sirRobinPattern = { "Sir Robin", R"(
+    4b2o$4bo2bo$4bo3bo$6b3o$2b2o6b4o$2bob2o4b4o$bo4bo6b3o$2b4o4b2o3bo$o9b
+    2o$bo3bo$6b3o2b2o2bo$2b2o7bo4bo$13bob2o$10b2o6bo$11b2ob3obo$10b2o3bo2b
+    o$10bobo2b2o$10bo2bobobo$10b3o6bo$11bobobo3bo$14b2obobo$11bo6b3o2$11bo
+    9bo$11bo3bo6bo$12bo5b5o$12b3o$16b2o$13b3o2bo$11bob3obo$10bo3bo2bo$11bo
+    4b2ob3o$13b4obo4b2o$13bob4o4b2o$19bo$20bo2b2o$20b2o$21b5o$25b2o$19b3o
+    6bo$20bobo3bobo$19bo3bo3bo$19bo3b2o$18bo6bob3o$19b2o3bo3b2o$20b4o2bo2b
+    o$22b2o3bo$21bo$21b2obo$20bo$19b5o$19bo4bo$18b3ob3o$18bob5o$18bo$20bo$
+    16bo4b4o$20b4ob2o$17b3o4bo$24bobo$28bo$24bo2b2o$25b3o$22b2o$21b3o5bo$
+    24b2o2bobo$21bo2b3obobo$22b2obo2bo$24bobo2b2o$26b2o$22b3o4bo$22b3o4bo$
+    23b2o3b3o$24b2ob2o$25b2o$25bo2$24b2o$26bo!
+    )", 31, 79, PatternNiemiec, { 0, 0, 26, 10, -20, -40, 120 } };
+
+const Pattern* const allPatterns[] = {
+  &lavaPattern,
+  &steepleChasePattern,
+  &p107rpentominoHasslerPattern,
+  &asj2023Pattern,
+  &snarkCatalystVariantsPattern,
+  &tannersP46GunPattern,
+  &rPentominoPattern,
+  &lobsterPattern,
+  &period201GliderGunPattern,
+  &sirRobinPattern,
+};
+const int nPatterns = sizeof(allPatterns) / sizeof(allPatterns[0]);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef Platform_h
+#define Platform_h
+
+// The few Arduino facilities the engines need, so that they also build as
+// native host programs (see env:native in platformio.ini)
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+
+typedef uint8_t byte;
+
+template <class A, class B>
+typename std::common_type<A, B>::type min(A a, B b) {
+  return a < b ? a : b;
+}
+template <class A, class B>
+typename std::common_type<A, B>::type max(A a, B b) {
+  return a > b ? a : b;
+}
+
+inline void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+// Random number in [0, max) or [min, max)
+inline long random(long max) {
+  return max > 0 ? rand() % max : 0;
+}
+inline long random(long min, long max) {
+  return min >= max ? min : min + random(max - min);
+}
+
+inline unsigned long millis() {
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Just the reading side of Arduino's Stream
+class Stream {
+public:
+  virtual ~Stream() {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual size_t write(uint8_t c) = 0;
+};
+
+#endif
+#endif
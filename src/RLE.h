@@ -0,0 +1,107 @@
+#ifndef RLE_h
+#define RLE_h
+
+#include "Platform.h"
+#include "Life.h"
+
+// The "x = 3, y = 3, rule = B3/S23" line that starts an RLE pattern. rule is
+// empty if the header does not give one, and any bounded grid suffix (as in
+// "12345/45678/8:T300,300") is dropped.
+struct RLEHeader {
+  const static int maxRuleLength = 64;
+  int width = 0;
+  int height = 0;
+  char rule[maxRuleLength] = "";
+};
+
+// Skip the comment lines (#) and header line at the start of rle, filling in
+// header if it isn't null, and return where the cells start
+inline const char* parseRLEHeader(const char* p, const char* end, RLEHeader* header) {
+  for (;;) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    if (p == end || (*p != '#' && *p != 'x')) return p;
+    const char* line = p;
+    while (p < end && *p != '\n' && *p) p++;
+    if (*line == '#' || !header) continue;
+    // key = value pairs separated by commas, where the rule runs to the end of
+    // the line since a bounded grid has a comma of its own
+    const char* c = line;
+    while (c < p) {
+      while (c < p && (*c == ' ' || *c == ',')) c++;
+      const char* key = c;
+      while (c < p && *c != '=' && *c != ' ') c++;
+      int keyLength = c - key;
+      while (c < p && (*c == ' ' || *c == '=')) c++;
+      if (keyLength == 4 && !strncmp(key, "rule", 4)) {
+        int n = 0;
+        while (c < p && *c != ':' && *c != '\r' && *c != ' ' && n < RLEHeader::maxRuleLength - 1) {
+          header->rule[n++] = *c++;
+        }
+        header->rule[n] = 0;
+        break;
+      }
+      int value = 0;
+      while (c < p && *c >= '0' && *c <= '9') value = value * 10 + *c++ - '0';
+      if (keyLength == 1 && *key == 'x') header->width = value;
+      if (keyLength == 1 && *key == 'y') header->height = value;
+      while (c < p && *c != ',') c++;
+    }
+  }
+}
+
+// Load a pattern in RLE format, held in memory from rle up to end, into life
+// with its top left corner at (xOff, yOff). Cells marked 'o' get one colour
+// per run, picked at random from 1 to nColors - 1, while 'A' to 'Z' are states
+// 1 to 26. The text is read in a single pass, and each run of live cells goes
+// to life in one setRun call. If header isn't null it gets the header line. If
+// oValue isn't 0, 'o' cells are set to it instead, so that a packed pattern can
+// mark them to be coloured when it is loaded (see PackedPattern.h).
+inline void loadRLE(Life& life, int xOff, int yOff, const char* rle, const char* end, int nColors,
+                    RLEHeader* header = 0, byte oValue = 0) {
+  life.clear();
+
+  const char* p = parseRLEHeader(rle, end, header);
+  int count = 0;
+  int x = xOff;
+  int y = yOff;
+  while (p < end) {
+    char c = *p++;
+    if (c >= '0' && c <= '9') {
+      count = count * 10 + c - '0';
+      continue;
+    }
+    switch (c) {
+      case ' ':
+      case '\n':
+      case '\r':
+      case '\t':
+        continue;
+      case '!':
+      case 0:
+        return;
+      case '#':
+        while (p < end && *p != '\n') p++;
+        continue;
+    }
+    if (count == 0) count = 1;
+    if (c == 'b' || c == '.') {
+      x += count;
+    } else if (c == 'o') {
+      life.setRun(x, y, count, oValue ? oValue : random(1, nColors));
+      x += count;
+    } else if (c >= 'A' && c <= 'Z') {
+      life.setRun(x, y, count, 1 + c - 'A');
+      x += count;
+    } else if (c == '$') {
+      y += count;
+      x = xOff;
+    }
+    count = 0;
+  }
+}
+
+inline void loadRLE(Life& life, int xOff, int yOff, const char* rle, int nColors, RLEHeader* header = 0) {
+  loadRLE(life, xOff, yOff, rle, rle + strlen(rle), nColors, header);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef Random_h
+#define Random_h
+
+#include "Platform.h"
+
+// xorshift64* generator, used in place of Arduino's random() wherever a run
+// should be repeatable. Its whole state is one word, so it can be saved with a
+// snapshot (see Snapshot.h) or printed, and set back to make the same choices.
+class LifeRandom {
+public:
+  LifeRandom(uint64_t seed = 1) {
+    randomSeed(seed);
+  }
+  // Any seed, 0 included, gives a usable state
+  void randomSeed(uint64_t seed) {
+    state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+  }
+  uint64_t getState() {
+    return state;
+  }
+  void setState(uint64_t newState) {
+    randomSeed(newState);
+  }
+  uint64_t next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+  }
+  // Random number in [0, max) or [min, max), as Arduino's random()
+  long random(long max) {
+    return max > 0 ? (long)((next() >> 32) % (unsigned long)max) : 0;
+  }
+  long random(long min, long max) {
+    return min >= max ? min : min + random(max - min);
+  }
+private:
+  uint64_t state;
+};
+
+#endif
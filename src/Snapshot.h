@@ -0,0 +1,225 @@
+#ifndef Snapshot_h
+#define Snapshot_h
+
+#include "Platform.h"
+#include "Life.h"
+
+// The state of a run at one generation, so that it can be saved, restored and
+// carried on from there instead of being run again from the start: the live
+// cells, packed as Life::setPacked takes them, the rule, the generation number
+// and the state of the run's random number generator (see Random.h).
+//
+// A snapshot is a block of ints in the byte order of the machine that took it
+// (little endian on both the Teensy and hosts):
+//   magic, length in ints, rule, nStates, bits per cell,
+//   generation (low, high), random state (low, high),
+//   x and y that the rows are relative to, then the rows
+// The rule is whatever number the caller names its rules by, PatternRule on
+// the matrix, so the same number must name the same rule when restoring. Every
+// engine steps the restored cells to exactly the generations the original run
+// had, except that InfiniteLife starts again without a cull radius.
+struct SnapshotInfo {
+  int rule = -1;
+  int nStates = 0;
+  int64_t generation = 0;
+  uint64_t randomState = 0;
+};
+
+class Snapshot {
+public:
+  const static int magic = 0x53434c43;  // "CLCS"
+  const static int headerInts = 11;
+
+  ~Snapshot() {
+    free(data);
+  }
+  // Take a snapshot of life, replacing the one held. Returns false if there
+  // was not the memory for it.
+  bool take(Life& life, const SnapshotInfo& info) {
+    // Engines visit their cells in different orders, so collect them and put
+    // them in (y, x) order if they aren't already
+    Cell* cells = 0;
+    int nCells = 0;
+    int allocCells = 0;
+    bool sorted = true;
+    bool ok = true;
+    int xMin = INT_MAX;
+    life.forEachLive([&](int x, int y, int value) {
+      if (!ok) return;
+      if (nCells == allocCells) {
+        int newAlloc = allocCells ? allocCells * 2 : 1024;
+        Cell* newCells = (Cell*)realloc(cells, sizeof(Cell) * newAlloc);
+        if (!newCells) {
+          ok = false;
+          return;
+        }
+        cells = newCells;
+        allocCells = newAlloc;
+      }
+      if (nCells && (y < cells[nCells - 1].y || (y == cells[nCells - 1].y && x < cells[nCells - 1].x))) sorted = false;
+      cells[nCells++] = { x, y, value };
+      xMin = min(xMin, x);
+    });
+    if (ok && !sorted) qsort(cells, nCells, sizeof(Cell), compareCells);
+    // At worst each cell takes a row marker and a word of its own
+    int* newData = ok ? (int*)realloc(data, sizeof(int) * (headerInts + 4 * (size_t)nCells)) : 0;
+    if (!newData) {
+      free(cells);
+      return false;
+    }
+    data = newData;
+    int yMin = nCells ? cells[0].y : 0;
+    if (!nCells) xMin = 0;
+    int bits = InfiniteLife::bitsPerCell(info.nStates);
+    int cellsPerWord = 64 / bits;
+    int n = headerInts;
+    int y = INT_MIN;
+    int wordX = 0;
+    int word = 0;
+    for (int i = 0; i < nCells; i++) {
+      const Cell& c = cells[i];
+      int x = c.x - xMin;
+      if (c.y != y) {
+        data[n++] = -(c.y - yMin + 1);
+        y = c.y;
+      } else if (x - wordX < cellsPerWord) {
+        int shift = bits * (x - wordX);
+        data[word + (shift >> 5)] |= (uint32_t)c.value << (shift & 31);
+        continue;
+      }
+      wordX = x;
+      data[n++] = x;
+      word = n;
+      data[n++] = c.value;
+      data[n++] = 0;
+    }
+    free(cells);
+    data[0] = magic;
+    data[1] = n;
+    data[2] = info.rule;
+    data[3] = info.nStates;
+    data[4] = bits;
+    data[5] = (uint32_t)info.generation;
+    data[6] = (uint32_t)((uint64_t)info.generation >> 32);
+    data[7] = (uint32_t)info.randomState;
+    data[8] = (uint32_t)(info.randomState >> 32);
+    data[9] = xMin;
+    data[10] = yMin;
+    length = n;
+    newData = (int*)realloc(data, sizeof(int) * n);
+    if (newData) data = newData;
+    return true;
+  }
+  // Replace the snapshot held with a copy of the one in bytes, as getData gave
+  // it. Returns false, leaving none held, if bytes isn't a whole snapshot.
+  bool assign(const void* bytes, size_t size) {
+    length = 0;
+    if (size < sizeof(int) * headerInts || size % sizeof(int)) return false;
+    int* newData = (int*)realloc(data, size);
+    if (!newData) return false;
+    data = newData;
+    memcpy(data, bytes, size);
+    if (!valid(size / sizeof(int))) return false;
+    length = size / sizeof(int);
+    return true;
+  }
+  // Read a snapshot written by write, for example from a file on the SD card.
+  // Snapshots of more than maxRowInts ints of rows are turned down before any
+  // memory is taken for them, so a corrupt length can't ask for gigabytes.
+  bool read(Stream& in, int maxRowInts = InfiniteLife::defaultMaxLength) {
+    length = 0;
+    int header[2];
+    if (!readBytes(in, header, sizeof(header)) || header[0] != magic || header[1] < headerInts) return false;
+    if (header[1] - headerInts > maxRowInts) return false;
+    int* newData = (int*)realloc(data, sizeof(int) * header[1]);
+    if (!newData) return false;
+    data = newData;
+    memcpy(data, header, sizeof(header));
+    if (!readBytes(in, data + 2, sizeof(int) * (header[1] - 2)) || !valid(header[1])) return false;
+    length = header[1];
+    return true;
+  }
+  // Write the snapshot held. Returns false if the stream would not take it all.
+  bool write(Stream& out) {
+    const byte* bytes = (const byte*)data;
+    size_t size = getBytes();
+    for (size_t i = 0; i < size; i++) {
+      if (out.write(bytes[i]) != 1) return false;
+    }
+    return true;
+  }
+  const void* getData() {
+    return data;
+  }
+  size_t getBytes() {
+    return sizeof(int) * length;
+  }
+  bool isEmpty() {
+    return length == 0;
+  }
+  // Returns false if no snapshot is held
+  bool getInfo(SnapshotInfo& info) {
+    if (!length) return false;
+    info.rule = data[2];
+    info.nStates = data[3];
+    info.generation = (int64_t)((uint32_t)data[5] | (uint64_t)(uint32_t)data[6] << 32);
+    info.randomState = (uint32_t)data[7] | (uint64_t)(uint32_t)data[8] << 32;
+    return true;
+  }
+  // Replace the cells of life with the snapshot's. life must already have the
+  // snapshot's rule; InfiniteLife then takes the rows as they are.
+  bool restore(Life& life) {
+    if (!length) return false;
+    life.clear();
+    life.setPacked(data[9], data[10], data + headerInts, length - headerInts, data[4]);
+    return true;
+  }
+private:
+  struct Cell {
+    int x;
+    int y;
+    int value;
+  };
+  static int compareCells(const void* a, const void* b) {
+    const Cell* p = (const Cell*)a;
+    const Cell* q = (const Cell*)b;
+    if (p->y != q->y) return p->y < q->y ? -1 : 1;
+    return p->x < q->x ? -1 : p->x > q->x;
+  }
+  static bool readBytes(Stream& in, void* buffer, size_t size) {
+    byte* bytes = (byte*)buffer;
+    for (size_t i = 0; i < size; i++) {
+      int c = in.read();
+      if (c < 0) return false;
+      bytes[i] = c;
+    }
+    return true;
+  }
+  // Check the header, and that the rows and the words in them are in order
+  // without overlapping, so that setPacked can trust them
+  bool valid(int n) {
+    int bits = data[4];
+    if (data[0] != magic || data[1] != n || data[3] < 1 || data[3] > 256) return false;
+    if (bits != InfiniteLife::bitsPerCell(data[3])) return false;
+    int cellsPerWord = 64 / bits;
+    int y = -1;
+    int x = 0;
+    for (int i = headerInts; i < n; i++) {
+      if (data[i] < 0) {
+        if (-data[i] - 1 <= y) return false;
+        y = -data[i] - 1;
+        x = -cellsPerWord;
+      } else {
+        if (y < 0 || data[i] - x < cellsPerWord || i + 2 >= n) return false;
+        x = data[i];
+        i += 2;
+      }
+    }
+    return true;
+  }
+
+  int* data = 0;
+  int length = 0;
+};
+
+#endif
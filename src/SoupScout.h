@@ -0,0 +1,162 @@
+#ifndef SoupScout_h
+#define SoupScout_h
+
+#include "Platform.h"
+#include "Life.h"
+#include "Random.h"
+
+// The soup startRandom shows: width x height cells from (0, 0), each live with
+// chance density, in one of the colours 1 to nColors - 1. The same rng state
+// always gives the same soup.
+inline void fillSoup(Life& life, LifeRandom& rng, int width, int height, float density, int nColors) {
+  life.clear();
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int r = rng.random(256);
+      if (r / 256. < density) life.set(x, y, 1 + r % (nColors - 1));
+    }
+  }
+}
+
+// Tries soups off screen on an engine of its own, in time the display would
+// otherwise spend waiting (see LEDMatrixLife::setIdleTask), and keeps the
+// seeds of the best ones so that the next soup shown is already known to be
+// worth showing. A seed is the LifeRandom state fillSoup starts from.
+//
+// Each soup runs until the whole state or the width x height window repeats,
+// the way LEDMatrixLife ends a run, or for horizon generations at most. That
+// is its lifespan. Soups that don't last minLifespan generations, or average
+// fewer than minMotion changing cells in the window, are dropped; the rest are
+// scored on their lifespan and the average live and changing cells in the
+// window, and the best maxQueued are kept.
+class SoupScout {
+public:
+  const static int maxQueued = 8;
+
+  // life is the scout's engine, already set to the rule soups are shown with
+  SoupScout(Life& life, int width, int height, int nColors, float density = 0.25)
+    : life(life), width(width), height(height), nColors(nColors), density(density) {}
+  void randomSeed(uint64_t seed) {
+    rng.randomSeed(seed);
+  }
+  void setHorizon(int generations) {
+    horizon = generations;
+  }
+  void setMinLifespan(int generations) {
+    minLifespan = generations;
+  }
+  void setMinMotion(int cells) {
+    minMotion = cells;
+  }
+  // Step the soup being tried, and start new ones, until millis() reaches
+  // deadline. The soup in progress carries on at the next call.
+  void work(unsigned long deadline) {
+    while ((long)(deadline - millis()) > 0) step();
+  }
+  // Take the best seed queued, returning false if there is none yet
+  bool take(uint64_t& seed) {
+    if (nQueued == 0) return false;
+    int best = 0;
+    for (int i = 1; i < nQueued; i++) {
+      if (queue[i].score > queue[best].score) best = i;
+    }
+    seed = queue[best].seed;
+    queue[best] = queue[--nQueued];
+    return true;
+  }
+  int getQueued() {
+    return nQueued;
+  }
+  // Soups tried so far, and how many of them were good enough to queue
+  long getTried() {
+    return tried;
+  }
+  long getKept() {
+    return kept;
+  }
+private:
+  struct Candidate {
+    uint64_t seed;
+    long score;
+  };
+
+  void begin() {
+    seed = rng.next();
+    LifeRandom soupRng(seed);
+    fillSoup(life, soupRng, width, height, density, nColors);
+    generation = 0;
+    populationSum = 0;
+    motionSum = 0;
+    stateCycles.clear();
+    windowCycles.clear();
+    running = true;
+  }
+
+  void step() {
+    if (!running) begin();
+    life.nextGeneration();
+    generation++;
+    long population = 0;
+    long motion = 0;
+    uint64_t windowHash = 0;
+    life.forEachLive([&](int x, int y, int value) {
+      if (x >= 0 && x < width && y >= 0 && y < height) {
+        population++;
+        windowHash += Life::cellHash(x, y, value);
+      }
+    });
+    life.iterateChanged([&](int x, int y, int) {
+      if (x >= 0 && x < width && y >= 0 && y < height) motion++;
+    });
+    populationSum += population;
+    motionSum += motion;
+    // Unlike the display, which holds a repeating pattern for a while in case
+    // it breaks out, the soup ends at the first repeat
+    int statePeriod = stateCycles.add(life.getHash());
+    int windowPeriod = windowCycles.add(windowHash);
+    if (statePeriod || windowPeriod || generation >= horizon) finish();
+  }
+
+  void finish() {
+    running = false;
+    tried++;
+    long meanPopulation = populationSum / generation;
+    long meanMotion = motionSum / generation;
+    if (generation < minLifespan || meanMotion < minMotion) return;
+    long score = generation + meanPopulation / 4 + meanMotion * 4;
+    kept++;
+    if (nQueued < maxQueued) {
+      queue[nQueued++] = { seed, score };
+      return;
+    }
+    int worst = 0;
+    for (int i = 1; i < nQueued; i++) {
+      if (queue[i].score < queue[worst].score) worst = i;
+    }
+    if (score > queue[worst].score) queue[worst] = { seed, score };
+  }
+
+  Life& life;
+  int width;
+  int height;
+  int nColors;
+  float density;
+  int horizon = 2000;
+  int minLifespan = 300;
+  int minMotion = 8;
+  LifeRandom rng;
+  // The soup being tried
+  bool running = false;
+  uint64_t seed = 0;
+  int generation = 0;
+  long populationSum = 0;
+  long motionSum = 0;
+  CycleDetector stateCycles;
+  CycleDetector windowCycles;
+  Candidate queue[maxQueued];
+  int nQueued = 0;
+  long tried = 0;
+  long kept = 0;
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include "Platform.h"
+
+// Per-frame timing of the display loop, to see which patterns push a frame past
+// its budget. Build with -DLIFE_TELEMETRY to enable it; otherwise the macros
+// below expand to nothing, and none of this costs anything.
+//
+// TELEMETRY_TIME(section) times the rest of the enclosing block against one of
+// the sections below, TELEMETRY_COUNT(n) counts pixels drawn, and
+// TELEMETRY_FRAME(liveCells) ends a frame. Every reportInterval frames a
+// summary is printed on Serial (stdout on a host build), with a histogram of
+// the time each section took per frame, in power of two microsecond buckets.
+
+enum TelemetrySection {
+  TelemetryGenerate,  // Life::nextGeneration
+  TelemetryIterate,   // Walking the live cells to build a whole frame
+  TelemetryChanges,   // Walking the changed cells, drawing them as we go
+  TelemetryDraw,      // fillScreen, drawPixel and direct row writes
+  TelemetrySwap,      // swapBuffers
+  TelemetrySections
+};
+
+#ifdef LIFE_TELEMETRY
+
+#ifdef ARDUINO
+#define TELEMETRY_PRINTF Serial.printf
+#else
+#define TELEMETRY_PRINTF printf
+#endif
+
+class Telemetry {
+public:
+  const static int nBuckets = 16;
+
+  static Telemetry& get() {
+    static Telemetry telemetry;
+    return telemetry;
+  }
+  // Cycle counter on the Teensy, nanoseconds on a host
+  static inline uint32_t now() {
+#ifdef ARDUINO
+    return ARM_DWT_CYCCNT;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+  static inline uint32_t toMicros(uint32_t ticks) {
+#ifdef ARDUINO
+    return ticks / (F_CPU_ACTUAL / 1000000);
+#else
+    return ticks / 1000;
+#endif
+  }
+
+  void add(int section, uint32_t ticks) {
+    current[section] += ticks;
+  }
+  void count(long pixels) {
+    this->pixels += pixels;
+  }
+  void frame(long liveCells) {
+    uint32_t total = 0;
+    for (int s = 0; s < TelemetrySections; s++) {
+      uint32_t micros = toMicros(current[s]);
+      record(sections[s], micros);
+      total += micros;
+      current[s] = 0;
+    }
+    record(sections[TelemetrySections], total);
+    if (frames == 0 || liveCells < minLive) minLive = liveCells;
+    if (liveCells > maxLive) maxLive = liveCells;
+    sumLive += liveCells;
+    if (++frames >= reportInterval) report();
+  }
+  // Print what has been gathered since the last report, and start again
+  void report() {
+    static const char* const names[] = { "generate", "iterate", "changes", "draw", "swap", "total" };
+    if (frames == 0) return;
+    TELEMETRY_PRINTF("Telemetry: %ld frames, live cells %ld/%ld/%ld min/avg/max, %ld pixels drawn\n", frames, minLive,
+                     sumLive / frames, maxLive, pixels);
+    for (int s = 0; s <= TelemetrySections; s++) {
+      Histogram& h = sections[s];
+      TELEMETRY_PRINTF("  %-8s avg %6lu us max %6lu us |", names[s], (unsigned long)(h.sum / frames), (unsigned long)h.max);
+      for (int b = 0; b < nBuckets; b++) {
+        if (h.counts[b]) TELEMETRY_PRINTF(" <%lu:%lu", 1ul << b, (unsigned long)h.counts[b]);
+      }
+      TELEMETRY_PRINTF("\n");
+    }
+    memset(sections, 0, sizeof(sections));
+    frames = 0;
+    pixels = 0;
+    minLive = maxLive = sumLive = 0;
+  }
+  void setReportInterval(long frames) {
+    reportInterval = frames;
+  }
+
+private:
+  // Bucket b counts frames that took less than 2^b us (the last also counts
+  // anything longer)
+  struct Histogram {
+    uint32_t counts[nBuckets];
+    uint64_t sum;
+    uint32_t max;
+  };
+
+  Telemetry() {
+    memset(sections, 0, sizeof(sections));
+  }
+  static void record(Histogram& h, uint32_t micros) {
+    int bucket = micros ? 32 - __builtin_clz(micros) : 0;
+    h.counts[min(bucket, nBuckets - 1)]++;
+    h.sum += micros;
+    if (micros > h.max) h.max = micros;
+  }
+
+  uint32_t current[TelemetrySections] = {};
+  // One per section, plus the total for the frame
+  Histogram sections[TelemetrySections + 1];
+  long frames = 0;
+  long reportInterval = 250;
+  long pixels = 0;
+  long minLive = 0;
+  long maxLive = 0;
+  long sumLive = 0;
+};
+
+// Adds the time from its construction to its destruction to a section
+class TelemetryTimer {
+public:
+  TelemetryTimer(int section)
+    : section(section), start(Telemetry::now()) {}
+  ~TelemetryTimer() {
+    Telemetry::get().add(section, Telemetry::now() - start);
+  }
+private:
+  int section;
+  uint32_t start;
+};
+
+#define TELEMETRY_CONCAT2(a, b) a##b
+#define TELEMETRY_CONCAT(a, b) TELEMETRY_CONCAT2(a, b)
+#define TELEMETRY_TIME(section) TelemetryTimer TELEMETRY_CONCAT(telemetryTimer, __LINE__)(section)
+#define TELEMETRY_COUNT(pixels) Telemetry::get().count(pixels)
+#define TELEMETRY_FRAME(liveCells) Telemetry::get().frame(liveCells)
+#define TELEMETRY_REPORT() Telemetry::get().report()
+
+#else
+
+#define TELEMETRY_TIME(section) do {} while (0)
+#define TELEMETRY_COUNT(pixels) do {} while (0)
+#define TELEMETRY_FRAME(liveCells) do {} while (0)
+#define TELEMETRY_REPORT() do {} while (0)
+
+#endif
+#endif
@@ -0,0 +1,127 @@
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+// Only available on hosts with threads, not on the Teensy
+#ifndef ARDUINO
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task queue. A worker takes
+// tasks from the back of its own queue, and when that is empty steals from the
+// front of the others, so uneven bands still keep every core busy.
+class ThreadPool {
+public:
+  ThreadPool(int nThreads = std::thread::hardware_concurrency()) {
+    if (nThreads < 1) nThreads = 1;
+    for (int i = 0; i < nThreads; i++) {
+      queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (int i = 0; i < nThreads; i++) {
+      workers.push_back(std::thread([this, i]() {
+        work(i);
+      }));
+    }
+  }
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+      stopping = true;
+    }
+    idle.notify_all();
+    for (std::thread& worker : workers) worker.join();
+  }
+  int getThreads() {
+    return workers.size();
+  }
+  // Runs f(i) for 0 <= i < n, and returns once they have all finished. The
+  // calling thread helps out while it waits.
+  template <class F>
+  void parallelFor(int n, F&& f) {
+    std::atomic<int> remaining(n);
+    for (int i = 0; i < n; i++) {
+      push(i % queues.size(), [&f, &remaining, i]() {
+        f(i);
+        remaining--;
+      });
+    }
+    std::function<void()> task;
+    while (remaining > 0) {
+      if (take(n % queues.size(), task)) {
+        task();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void push(int q, std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(queues[q]->mutex);
+      queues[q]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+      queued++;
+    }
+    idle.notify_one();
+  }
+
+  // Take from our own queue if possible, otherwise steal
+  bool take(int q, std::function<void()>& task) {
+    int n = queues.size();
+    for (int i = 0; i < n; i++) {
+      Queue& queue = *queues[(q + i) % n];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) continue;
+      if (i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      std::lock_guard<std::mutex> idleLock(idleMutex);
+      queued--;
+      return true;
+    }
+    return false;
+  }
+
+  void work(int q) {
+    std::function<void()> task;
+    for (;;) {
+      if (take(q, task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(idleMutex);
+      idle.wait(lock, [this]() {
+        return stopping || queued > 0;
+      });
+      if (stopping) return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex idleMutex;
+  std::condition_variable idle;
+  int queued = 0;
+  bool stopping = false;
+};
+
+#endif
+#endif
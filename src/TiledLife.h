@@ -0,0 +1,420 @@
+#ifndef TiledLife_h
+#define TiledLife_h
+
+#include "BitKernel.h"
+#include "Life.h"
+
+// An unbounded universe stored as 16x16 tiles, kept in a hash map keyed by tile
+// coordinates. Each tile holds its cells as bit planes (bit p of a cell's state
+// in plane p, one 16 bit word per row). Only tiles with live cells are kept, so
+// memory stays proportional to the live area, and unlike InfiniteLife cells can
+// be set and read in any order. Tiles come from a pool, and are recycled rather
+// than freed.
+//
+// Each generation, every tile is stepped from an 18x18 window of its own cells
+// plus a one cell halo taken from its neighbors. For Generations rules (B3/S23
+// included) the window holds just the live cells, a row to a word, and each
+// row of the tile is stepped at once with GenerationsKernel's adder network;
+// other rules are evaluated cell by cell. Empty tiles are created next to live
+// cells on the edge of a tile, so that patterns can grow into them.
+class TiledLife : public Life {
+public:
+  TiledLife(int nStates, TreeRule* treeRule)
+    : treeRule(treeRule) {
+    setRule(nStates, treeRule);
+  }
+  ~TiledLife() {
+    while (blocks) {
+      Block* block = blocks;
+      blocks = block->next;
+      free(block);
+    }
+    free(pending);
+  }
+  virtual void setRule(int nStates, TreeRule* rule) {
+    treeRule = rule;
+    compiledRule.compile(nStates, rule);
+    nPlanes = 1;
+    while ((1 << nPlanes) < nStates) nPlanes++;
+    assert(nPlanes <= maxPlanes);
+    generations = kernel.classify(nStates, rule, compiledRule);
+    clear();
+  }
+  virtual void clear() {
+    tiles.forEach([this](Tile* tile) {
+      release(tile);
+    });
+    tiles.clear();
+  }
+  byte get(int x, int y) {
+    Tile* tile = tiles.find(x >> tileShift, y >> tileShift);
+    if (!tile) return 0;
+    return tile->get(x & tileMask, y & tileMask, nPlanes);
+  }
+  virtual void set(int x, int y, byte value) {
+    int tx = x >> tileShift, ty = y >> tileShift;
+    Tile* tile = tiles.find(tx, ty);
+    if (!tile) {
+      if (value == 0) return;
+      tile = allocate(tx, ty);
+      tiles.insert(tile);
+    }
+    tile->set(x & tileMask, y & tileMask, value, nPlanes);
+  }
+  virtual void nextGeneration() {
+    addEdgeTiles();
+    tiles.forEach([this](Tile* tile) {
+      Tile* result = step(tile);
+      if (result) nextTiles.insert(result);
+    });
+    tiles.forEach([this](Tile* tile) {
+      release(tile);
+    });
+    tiles.clear();
+    tiles.swap(nextTiles);
+  }
+  virtual void iterateLiveRuns(RunVisitor& visitor) {
+    forEachLiveRun([&visitor](int x, int y, int length, const byte* values) {
+      visitor.visit(x, y, length, values);
+    });
+  }
+  // Each non-empty row of a tile is one span of 16 cells. Tiles are visited in
+  // no particular order.
+  template <class F>
+  void forEachLiveRun(F&& f) {
+    byte values[tileSize];
+    tiles.forEach([&](Tile* tile) {
+      for (int y = 0; y < tileSize; y++) {
+        if (!tile->occupied(y, nPlanes)) continue;
+        for (int x = 0; x < tileSize; x++) values[x] = tile->get(x, y, nPlanes);
+        f(tile->tx * tileSize, tile->ty * tileSize + y, tileSize, values);
+      }
+    });
+  }
+  template <class F>
+  void forEachLive(F&& f) {
+    forEachLiveRun([&f](int x, int y, int length, const byte* values) {
+      for (int i = 0; i < length; i++) {
+        if (values[i]) f(x + i, y, values[i]);
+      }
+    });
+  }
+  // True if the current rule is stepped with the bitwise Generations kernel
+  bool isGenerations() {
+    return generations;
+  }
+  // Number of tiles currently in use
+  int getTileCount() {
+    return tiles.size();
+  }
+  // Number of tiles allocated from the heap, in use or free
+  int getPoolSize() {
+    return poolSize;
+  }
+  virtual size_t getStateBytes() {
+    return sizeof(Block) * (poolSize / blockTiles) + tiles.bucketBytes() + nextTiles.bucketBytes();
+  }
+
+private:
+  const static int tileShift = 4;
+  const static int tileSize = 1 << tileShift;
+  const static int tileMask = tileSize - 1;
+  const static int maxPlanes = 8;
+  const static int blockTiles = 64;
+
+  struct Tile {
+    int tx;
+    int ty;
+    // Next tile in the same hash bucket, or in the free list
+    Tile* chain;
+    uint16_t planes[maxPlanes][tileSize];
+
+    byte get(int x, int y, int nPlanes) {
+      byte value = 0;
+      for (int p = 0; p < nPlanes; p++) {
+        value |= ((planes[p][y] >> x) & 1) << p;
+      }
+      return value;
+    }
+    void set(int x, int y, byte value, int nPlanes) {
+      uint16_t bit = 1 << x;
+      for (int p = 0; p < nPlanes; p++) {
+        if ((value >> p) & 1) {
+          planes[p][y] |= bit;
+        } else {
+          planes[p][y] &= ~bit;
+        }
+      }
+    }
+    uint16_t occupied(int y, int nPlanes) {
+      uint16_t bits = 0;
+      for (int p = 0; p < nPlanes; p++) bits |= planes[p][y];
+      return bits;
+    }
+    // Cells in state 1
+    uint16_t live(int y, int nPlanes) {
+      uint16_t bits = planes[0][y];
+      for (int p = 1; p < nPlanes; p++) bits &= ~planes[p][y];
+      return bits;
+    }
+  };
+
+  struct Block {
+    Block* next;
+    Tile tiles[blockTiles];
+  };
+
+  // Chained hash map from tile coordinates to tiles, growing as tiles are added
+  class TileMap {
+  public:
+    TileMap() {}
+    TileMap(const TileMap&) = delete;
+    ~TileMap() {
+      free(buckets);
+    }
+    Tile* find(int tx, int ty) {
+      if (!count) return 0;
+      for (Tile* tile = buckets[hash(tx, ty) & (nBuckets - 1)]; tile; tile = tile->chain) {
+        if (tile->tx == tx && tile->ty == ty) return tile;
+      }
+      return 0;
+    }
+    void insert(Tile* tile) {
+      if (count >= nBuckets) grow();
+      Tile*& bucket = buckets[hash(tile->tx, tile->ty) & (nBuckets - 1)];
+      tile->chain = bucket;
+      bucket = tile;
+      count++;
+    }
+    // Forget all tiles, which must already have been released
+    void clear() {
+      if (count) memset(buckets, 0, sizeof(Tile*) * nBuckets);
+      count = 0;
+    }
+    int size() {
+      return count;
+    }
+    size_t bucketBytes() {
+      return sizeof(Tile*) * nBuckets;
+    }
+    void swap(TileMap& other) {
+      Tile** b = buckets;
+      buckets = other.buckets;
+      other.buckets = b;
+      int n = nBuckets;
+      nBuckets = other.nBuckets;
+      other.nBuckets = n;
+      n = count;
+      count = other.count;
+      other.count = n;
+    }
+    // f may release the tile it is given, but must not insert
+    template <class F>
+    void forEach(F&& f) {
+      for (int i = 0; i < nBuckets; i++) {
+        for (Tile* tile = buckets[i]; tile;) {
+          Tile* chain = tile->chain;
+          f(tile);
+          tile = chain;
+        }
+      }
+    }
+  private:
+    static uint32_t hash(int tx, int ty) {
+      uint32_t h = (uint32_t)tx * 0x9E3779B1u ^ (uint32_t)ty * 0x85EBCA77u;
+      return h ^ (h >> 15);
+    }
+    void grow() {
+      Tile** old = buckets;
+      int oldBuckets = nBuckets;
+      nBuckets = nBuckets ? nBuckets * 2 : 64;
+      buckets = (Tile**)calloc(nBuckets, sizeof(Tile*));
+      count = 0;
+      for (int i = 0; i < oldBuckets; i++) {
+        for (Tile* tile = old[i]; tile;) {
+          Tile* chain = tile->chain;
+          insert(tile);
+          tile = chain;
+        }
+      }
+      free(old);
+    }
+    Tile** buckets = 0;
+    int nBuckets = 0;
+    int count = 0;
+  };
+
+  // Take an empty tile from the pool, allocating another block if needed
+  Tile* allocate(int tx, int ty) {
+    if (!freeList) {
+      Block* block = (Block*)malloc(sizeof(Block));
+      block->next = blocks;
+      blocks = block;
+      for (int i = 0; i < blockTiles; i++) release(&block->tiles[i]);
+      poolSize += blockTiles;
+    }
+    Tile* tile = freeList;
+    freeList = tile->chain;
+    tile->tx = tx;
+    tile->ty = ty;
+    tile->chain = 0;
+    memset(tile->planes, 0, sizeof(tile->planes));
+    return tile;
+  }
+  void release(Tile* tile) {
+    tile->chain = freeList;
+    freeList = tile;
+  }
+
+  // Live cells on the edge of a tile can give birth in the neighboring tile,
+  // so make sure it exists before stepping
+  void addEdgeTiles() {
+    nPending = 0;
+    tiles.forEach([this](Tile* tile) {
+      uint16_t top = tile->occupied(0, nPlanes);
+      uint16_t bottom = tile->occupied(tileMask, nPlanes);
+      uint16_t any = 0;
+      for (int y = 0; y < tileSize; y++) any |= tile->occupied(y, nPlanes);
+      bool left = any & 1, right = any >> tileMask;
+      int tx = tile->tx, ty = tile->ty;
+      if (top) addPending(tx, ty - 1);
+      if (bottom) addPending(tx, ty + 1);
+      if (left) addPending(tx - 1, ty);
+      if (right) addPending(tx + 1, ty);
+      if (top & 1) addPending(tx - 1, ty - 1);
+      if (top >> tileMask) addPending(tx + 1, ty - 1);
+      if (bottom & 1) addPending(tx - 1, ty + 1);
+      if (bottom >> tileMask) addPending(tx + 1, ty + 1);
+    });
+    for (int i = 0; i < nPending; i += 2) {
+      int tx = pending[i], ty = pending[i + 1];
+      if (!tiles.find(tx, ty)) tiles.insert(allocate(tx, ty));
+    }
+  }
+  void addPending(int tx, int ty) {
+    if (tiles.find(tx, ty)) return;
+    if (nPending + 2 > pendingLength) {
+      pendingLength = pendingLength ? pendingLength * 2 : 256;
+      pending = (int*)realloc(pending, sizeof(int) * pendingLength);
+    }
+    pending[nPending++] = tx;
+    pending[nPending++] = ty;
+  }
+
+  // Compute the next generation of one tile, or return 0 if it will be empty
+  Tile* step(Tile* tile) {
+    return generations ? stepGenerations(tile) : stepGeneric(tile);
+  }
+
+  Tile* stepGenerations(Tile* tile) {
+    typedef ScalarWord<uint32_t> Word;
+    // Live cells of the tile and its halo, with cell x of the tile in bit x + 1
+    uint32_t live[tileSize + 2];
+    memset(live, 0, sizeof(live));
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        Tile* source = dx == 0 && dy == 0 ? tile : tiles.find(tile->tx + dx, tile->ty + dy);
+        if (!source) continue;
+        int y0 = dy < 0 ? tileMask : 0, y1 = dy > 0 ? 1 : tileSize;
+        for (int y = y0; y < y1; y++) {
+          uint32_t bits = source->live(y, nPlanes);
+          uint32_t& row = live[y + 1 + dy * tileSize];
+          if (dx < 0) {
+            row |= bits >> tileMask;
+          } else if (dx > 0) {
+            row |= (bits & 1) << (tileSize + 1);
+          } else {
+            row |= bits << 1;
+          }
+        }
+      }
+    }
+    Tile* result = 0;
+    Word planes[GenerationsKernel::maxPlanes];
+    Word next[GenerationsKernel::maxPlanes];
+    for (int y = 0; y < tileSize; y++) {
+      // Shift the neighbors to the left, above and to the right into line
+      // with the cells, which are then in bits 0 to 15
+      Word a = { live[y] }, b = { live[y + 1] }, c = { live[y + 2] };
+      Word s0, s1, s2, s3;
+      GenerationsKernel::count(a, a.shr<1>(), a.shr<2>(), b, b.shr<2>(), c, c.shr<1>(), c.shr<2>(), s0, s1, s2, s3);
+      for (int p = 0; p < nPlanes; p++) planes[p] = { tile->planes[p][y] };
+      kernel.step(planes, s0, s1, s2, s3, next);
+      uint16_t any = 0;
+      for (int p = 0; p < nPlanes; p++) any |= next[p].v;
+      if (!any) continue;
+      if (!result) result = allocate(tile->tx, tile->ty);
+      for (int p = 0; p < nPlanes; p++) result->planes[p][y] = next[p].v;
+    }
+    return result;
+  }
+
+  Tile* stepGeneric(Tile* tile) {
+    const int w = tileSize + 2;
+    // Unpack the tile and its halo. Row/column 0 and w-1 come from the neighbors.
+    byte window[w][w];
+    memset(window, 0, sizeof(window));
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        Tile* source = dx == 0 && dy == 0 ? tile : tiles.find(tile->tx + dx, tile->ty + dy);
+        if (!source) continue;
+        int x0 = dx < 0 ? tileMask : 0, x1 = dx > 0 ? 1 : tileSize;
+        int y0 = dy < 0 ? tileMask : 0, y1 = dy > 0 ? 1 : tileSize;
+        for (int y = y0; y < y1; y++) {
+          byte* row = window[y + 1 + dy * tileSize];
+          for (int p = 0; p < nPlanes; p++) {
+            uint16_t bits = source->planes[p][y];
+            for (int x = x0; x < x1; x++) {
+              row[x + 1 + dx * tileSize] |= ((bits >> x) & 1) << p;
+            }
+          }
+        }
+      }
+    }
+    // Cells with nothing in their neighborhood stay empty without evaluating the rule
+    uint32_t occupied[w];
+    for (int y = 0; y < w; y++) {
+      uint32_t bits = 0;
+      for (int x = 0; x < w; x++) bits |= (uint32_t)(window[y][x] != 0) << x;
+      occupied[y] = bits;
+    }
+    Tile* result = 0;
+    for (int y = 0; y < tileSize; y++) {
+      uint32_t column = occupied[y] | occupied[y + 1] | occupied[y + 2];
+      // Bit x is set if cell x (window column x + 1) has anything around it
+      uint32_t active = (column | (column >> 1) | (column >> 2)) & 0xffff;
+      while (active) {
+        int x = __builtin_ctz(active);
+        active &= active - 1;
+        int neighbors[] = {
+          window[y][x], window[y][x + 1], window[y][x + 2],
+          window[y + 1][x], window[y + 1][x + 2],
+          window[y + 2][x], window[y + 2][x + 1], window[y + 2][x + 2],
+          window[y + 1][x + 1]
+        };
+        int value = compiledRule.transition(neighbors);
+        if (!value) continue;
+        if (!result) result = allocate(tile->tx, tile->ty);
+        for (int p = 0; p < nPlanes; p++) {
+          result->planes[p][y] |= ((value >> p) & 1) << x;
+        }
+      }
+    }
+    return result;
+  }
+
+  int nPlanes;
+  bool generations;
+  GenerationsKernel kernel;
+  TileMap tiles;
+  TileMap nextTiles;
+  Tile* freeList = 0;
+  Block* blocks = 0;
+  int poolSize = 0;
+  int* pending = 0;
+  int nPending = 0;
+  int pendingLength = 0;
+  TreeRule* treeRule;
+  CompiledRule compiledRule;
+};
+#endif
@@ -0,0 +1,220 @@
+// Benchmarks of the Life engines over the patterns shown on the matrix, plus
+// random soups, on a desktop host. Build with "pio run -e bench".
+//
+// LifeBench [options]
+//   -n gens     generations per case (default 1000)
+//   -f filter   only run cases whose name contains filter
+//   -t threads  step on a thread pool, where the engine supports it
+//   --json file also write the results to file as JSON
+//
+// Each case loads a pattern into one engine and times only the calls to
+// nextGeneration. Population is sampled every 16 generations, outside the
+// timed region, to estimate cells processed per second. Allocations made while
+// stepping are counted by wrapping malloc, where the C library allows it.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../BitLife.h"
+#include "../HashLife.h"
+#include "../Life.h"
+#include "../Patterns.h"
+#include "../RLE.h"
+#include "../ThreadPool.h"
+#include "../TiledLife.h"
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void __libc_free(void* p);
+
+static long allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t n, size_t size) {
+  allocations++;
+  return __libc_calloc(n, size);
+}
+extern "C" void* realloc(void* p, size_t size) {
+  allocations++;
+  return __libc_realloc(p, size);
+}
+extern "C" void free(void* p) {
+  __libc_free(p);
+}
+#else
+static long allocations = -1;
+#endif
+
+// Universe size for the fixed size engines, with patterns centered in it
+const int fixedSize = 128;
+// Soups fill a square this size at the center of the universe
+const int soupSize = 64;
+const int sampleInterval = 16;
+
+struct Result {
+  char name[96];
+  long generations;
+  double seconds;
+  double cellsPerSecond;
+  double generationsPerSecond;
+  size_t stateBytes;
+  long allocations;
+  long population;
+};
+
+const char* const engines[] = { "infinite", "simple", "bit", "tiled", "hash" };
+
+static Life* createEngine(const char* engine, int nStates, TreeRule* rule, ThreadPool* pool) {
+  if (!strcmp(engine, "infinite")) {
+    InfiniteLife* infinite = new InfiniteLife(nStates, rule);
+    infinite->setThreadPool(pool);
+    return infinite;
+  } else if (!strcmp(engine, "simple")) {
+    SimpleLife* simple = new SimpleLife(fixedSize, fixedSize, rule);
+    simple->setRule(nStates, rule);
+    simple->setThreadPool(pool);
+    return simple;
+  } else if (!strcmp(engine, "bit")) {
+    return new BitLife(fixedSize, fixedSize, nStates, rule);
+  } else if (!strcmp(engine, "tiled")) {
+    return new TiledLife(nStates, rule);
+  }
+  return new HashLife(nStates, rule);
+}
+
+static long population(Life* life) {
+  long n = 0;
+  life->forEachLive([&n](int, int, int) {
+    n++;
+  });
+  return n;
+}
+
+static Result run(const char* name, Life* life, long generations) {
+  Result result;
+  snprintf(result.name, sizeof(result.name), "%s", name);
+  result.generations = generations;
+  double cells = 0;
+  double seconds = 0;
+  long startAllocations = allocations;
+  for (long g = 0; g < generations; g += sampleInterval) {
+    long n = min((long)sampleInterval, generations - g);
+    cells += (double)population(life) * n;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) life->nextGeneration();
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  result.allocations = allocations < 0 ? -1 : allocations - startAllocations;
+  result.seconds = seconds;
+  result.cellsPerSecond = seconds > 0 ? cells / seconds : 0;
+  result.generationsPerSecond = seconds > 0 ? generations / seconds : 0;
+  result.stateBytes = life->getStateBytes();
+  result.population = population(life);
+  return result;
+}
+
+static void print(const Result& r) {
+  printf("%-44s %10.2f ms %12.0f gen/s %12.3g cells/s %10zu B %8ld allocs %8ld pop\n", r.name, r.seconds * 1000,
+         r.generationsPerSecond, r.cellsPerSecond, r.stateBytes, r.allocations, r.population);
+  fflush(stdout);
+}
+
+static void writeJson(const char* path, Result* results, int n, long generations) {
+  FILE* file = fopen(path, "w");
+  if (!file) {
+    perror(path);
+    return;
+  }
+  fprintf(file, "{\n  \"context\": { \"generations\": %ld, \"fixed_size\": %d },\n  \"benchmarks\": [\n", generations,
+          fixedSize);
+  for (int i = 0; i < n; i++) {
+    const Result& r = results[i];
+    fprintf(file,
+            "    { \"name\": \"%s\", \"generations\": %ld, \"real_time_s\": %.6f, \"generations_per_second\": %.1f, "
+            "\"cells_per_second\": %.1f, \"state_bytes\": %zu, \"allocations\": %ld, \"population\": %ld }%s\n",
+            r.name, r.generations, r.seconds, r.generationsPerSecond, r.cellsPerSecond, r.stateBytes, r.allocations,
+            r.population, i + 1 < n ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: LifeBench [-n gens] [-f filter] [-t threads] [--json file]\n");
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  long generations = 1000;
+  const char* filter = "";
+  const char* json = 0;
+  int threads = 0;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) usage();
+    const char* value = argv[++i];
+    if (!strcmp(arg, "--json")) {
+      json = value;
+    } else if (!strcmp(arg, "-n")) {
+      generations = atol(value);
+    } else if (!strcmp(arg, "-f")) {
+      filter = value;
+    } else if (!strcmp(arg, "-t")) {
+      threads = atoi(value);
+    } else {
+      usage();
+    }
+  }
+
+  ThreadPool* pool = threads > 0 ? new ThreadPool(threads) : 0;
+  const double densities[] = { 0.1, 0.25, 0.5 };
+  const int nEngines = sizeof(engines) / sizeof(engines[0]);
+  const int nDensities = sizeof(densities) / sizeof(densities[0]);
+  int maxResults = (nPatterns + nDensities) * nEngines;
+  Result* results = (Result*)malloc(sizeof(Result) * maxResults);
+  int nResults = 0;
+
+  for (int e = 0; e < nEngines; e++) {
+    const char* engine = engines[e];
+    for (int p = 0; p < nPatterns + nDensities; p++) {
+      char name[96];
+      if (p < nPatterns) {
+        snprintf(name, sizeof(name), "%s/%s", engine, allPatterns[p]->name);
+      } else {
+        snprintf(name, sizeof(name), "%s/soup %.2f", engine, densities[p - nPatterns]);
+      }
+      if (!strstr(name, filter)) continue;
+      int nStates;
+      TreeRule* rule = patternTreeRule(p < nPatterns ? allPatterns[p]->rule : PatternNiemiec, nStates);
+      Life* life = createEngine(engine, nStates, rule, pool);
+      randomSeed(1);
+      if (p < nPatterns) {
+        const Pattern* pattern = allPatterns[p];
+        loadRLE(*life, (fixedSize - pattern->width) / 2, (fixedSize - pattern->height) / 2, pattern->rle, nStates);
+      } else {
+        double density = densities[p - nPatterns];
+        int offset = (fixedSize - soupSize) / 2;
+        life->clear();
+        for (int y = 0; y < soupSize; y++) {
+          for (int x = 0; x < soupSize; x++) {
+            if (random(1000000) < density * 1000000) life->set(x + offset, y + offset, random(1, nStates));
+          }
+        }
+      }
+      results[nResults] = run(name, life, generations);
+      print(results[nResults++]);
+      delete life;
+    }
+  }
+  if (json) writeJson(json, results, nResults, generations);
+  free(results);
+  delete pool;
+  return 0;
+}
@@ -0,0 +1,344 @@
+// Headless runner for the Life engines on a desktop host, for profiling
+// without the matrix attached. Build with "pio run -e native".
+//
+// LifeCli [options] [pattern.rle|pattern.mc|saved.snap]
+//   -e engine   infinite (default), simple, bit, tiled or hash
+//   -r rule     niemiec (B3/S23), generations (12345/45678/8),
+//               generations1 (345/2/4), any rule string CountRule accepts, or
+//               a Golly .rule file with a @TREE or @TABLE. The default is the
+//               rule in the pattern's header if it has one, otherwise niemiec.
+//   -c colours  with a rule string, Colourised Life using the quad (4 colour)
+//               or niemiec (8 colour) colorizer
+//   -n gens     generations to run (default 1000)
+//   -s size     universe size for the fixed size engines (default 64)
+//   -d density  fill a size x size square at random with this density when
+//               no pattern is given (default 0.25)
+//   -t threads  step on a thread pool, where the engine supports it
+//   -S seed     random seed (default 1)
+//   -w out.mc   write the final generation to out.mc in macrocell format
+//   -k out.snap keep a snapshot of the final generation in out.snap
+//
+// Macrocell patterns are built straight into the hash engine's quadtree, and
+// given to the other engines a row at a time. A snapshot carries on from the
+// generation it was taken at, with its own rule unless -r is given, on any
+// engine.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../BitLife.h"
+#include "../GollyRule.h"
+#include "../HashLife.h"
+#include "../Life.h"
+#include "../Macrocell.h"
+#include "../Random.h"
+#include "../RLE.h"
+#include "../Snapshot.h"
+#include "../ThreadPool.h"
+#include "../TiledLife.h"
+
+class FileStream : public Stream {
+public:
+  FileStream(FILE* file)
+    : file(file) {}
+  int available() {
+    return feof(file) ? 0 : 1;
+  }
+  int read() {
+    return fgetc(file);
+  }
+  int peek() {
+    int c = fgetc(file);
+    if (c != EOF) ungetc(c, file);
+    return c;
+  }
+  size_t write(uint8_t /*c*/) {
+    return 0;
+  }
+private:
+  FILE* file;
+};
+
+// Names of the rules a snapshot records, by their PatternRule numbers. Other
+// rules are recorded as -1, and have to be given again with -r.
+static const char* const snapshotRules[] = { "niemiec", "generations", "generations1" };
+const int nSnapshotRules = sizeof(snapshotRules) / sizeof(snapshotRules[0]);
+
+static bool hasExtension(const char* path, const char* extension) {
+  size_t length = strlen(path);
+  size_t extensionLength = strlen(extension);
+  return length > extensionLength && !strcmp(path + length - extensionLength, extension);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: LifeCli [-e infinite|simple|bit|tiled|hash] [-r niemiec|generations|generations1|rule]\n"
+                  "               [-c quad|niemiec] [-n gens] [-s size] [-d density] [-t threads] [-S seed]\n"
+                  "               [-w out.mc] [-k out.snap] [pattern.rle|pattern.mc|saved.snap]\n");
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  const char* engine = "infinite";
+  const char* ruleName = 0;
+  const char* colours = 0;
+  const char* pattern = 0;
+  const char* output = 0;
+  const char* snapshotOutput = 0;
+  long generations = 1000;
+  int size = 64;
+  double density = 0.25;
+  int threads = 0;
+  unsigned long seed = 1;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      pattern = arg;
+      continue;
+    }
+    if (i + 1 >= argc) usage();
+    const char* value = argv[++i];
+    switch (arg[1]) {
+      case 'e': engine = value; break;
+      case 'r': ruleName = value; break;
+      case 'c': colours = value; break;
+      case 'n': generations = atol(value); break;
+      case 's': size = atoi(value); break;
+      case 'd': density = atof(value); break;
+      case 't': threads = atoi(value); break;
+      case 'S': seed = strtoul(value, 0, 10); break;
+      case 'w': output = value; break;
+      case 'k': snapshotOutput = value; break;
+      default: usage();
+    }
+  }
+  randomSeed(seed);
+  LifeRandom rng(seed);
+
+  // The pattern is read into memory whole and parsed from there
+  char* text = 0;
+  size_t textLength = 0;
+  RLEHeader header;
+  MacrocellHeader macrocellHeader;
+  bool macrocell = pattern && hasExtension(pattern, ".mc");
+  bool restoring = pattern && hasExtension(pattern, ".snap");
+  Snapshot snapshot;
+  SnapshotInfo snapshotInfo;
+  if (pattern) {
+    FILE* file = fopen(pattern, "rb");
+    if (!file) {
+      perror(pattern);
+      return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    text = (char*)malloc(length > 0 ? length : 1);
+    textLength = length > 0 ? fread(text, 1, length, file) : 0;
+    fclose(file);
+    if (restoring) {
+      if (!snapshot.assign(text, textLength)) {
+        fprintf(stderr, "%s is not a snapshot\n", pattern);
+        return 1;
+      }
+      snapshot.getInfo(snapshotInfo);
+      if (snapshotInfo.rule >= 0 && snapshotInfo.rule < nSnapshotRules) strcpy(header.rule, snapshotRules[snapshotInfo.rule]);
+    } else if (macrocell) {
+      parseMacrocellHeader(text, text + textLength, macrocellHeader);
+      strcpy(header.rule, macrocellHeader.rule);
+    } else {
+      parseRLEHeader(text, text + textLength, &header);
+    }
+  }
+  if (!ruleName && restoring && !header.rule[0]) {
+    fprintf(stderr, "%s needs its rule given with -r\n", pattern);
+    return 1;
+  }
+  if (!ruleName) ruleName = header.rule[0] ? header.rule : "niemiec";
+
+  NiemiecTreeRule niemiec;
+  GenerationsTreeRule generationsRule;
+  Generations1TreeRule generations1;
+  Quadlife quadlife;
+  Niemieclife niemieclife;
+  Colorizer* colorizer = 0;
+  if (colours) {
+    if (!strcmp(colours, "quad")) {
+      colorizer = &quadlife;
+    } else if (!strcmp(colours, "niemiec")) {
+      colorizer = &niemieclife;
+    } else {
+      fprintf(stderr, "unknown colorizer %s\n", colours);
+      return 1;
+    }
+  }
+  CountRule countRule(colorizer);
+  GollyRule* gollyRule = 0;
+  TreeRule* rule;
+  int nStates;
+  if (!strcmp(ruleName, "niemiec")) {
+    rule = &niemiec;
+    nStates = 9;
+  } else if (!strcmp(ruleName, "generations")) {
+    rule = &generationsRule;
+    nStates = 8;
+  } else if (!strcmp(ruleName, "generations1")) {
+    rule = &generations1;
+    nStates = 4;
+  } else if (strstr(ruleName, ".rule")) {
+    FILE* file = fopen(ruleName, "r");
+    if (!file) {
+      perror(ruleName);
+      return 1;
+    }
+    FileStream stream(file);
+    gollyRule = loadGollyRule(stream);
+    fclose(file);
+    if (!gollyRule) {
+      fprintf(stderr, "can't read rule %s\n", ruleName);
+      return 1;
+    }
+    rule = gollyRule;
+    nStates = gollyRule->getNStates();
+  } else if (countRule.parse(ruleName)) {
+    rule = &countRule;
+    nStates = countRule.getNStates();
+  } else {
+    fprintf(stderr, "unknown rule %s\n", ruleName);
+    return 1;
+  }
+
+  ThreadPool* pool = threads > 0 ? new ThreadPool(threads) : 0;
+  Life* life;
+  HashLife* hashLife = 0;
+  if (!strcmp(engine, "infinite")) {
+    InfiniteLife* infinite = new InfiniteLife(nStates, rule);
+    infinite->setThreadPool(pool);
+    life = infinite;
+  } else if (!strcmp(engine, "simple")) {
+    SimpleLife* simple = new SimpleLife(size, size, rule);
+    simple->setRule(nStates, rule);
+    simple->setThreadPool(pool);
+    life = simple;
+  } else if (!strcmp(engine, "bit")) {
+    life = new BitLife(size, size, nStates, rule);
+  } else if (!strcmp(engine, "tiled")) {
+    life = new TiledLife(nStates, rule);
+  } else if (!strcmp(engine, "hash")) {
+    life = hashLife = new HashLife(nStates, rule);
+  } else {
+    fprintf(stderr, "unknown engine %s\n", engine);
+    return 1;
+  }
+
+  int64_t firstGeneration = 0;
+  if (restoring) {
+    if (snapshotInfo.nStates != nStates) {
+      fprintf(stderr, "%s has %d states, but rule %s has %d\n", pattern, snapshotInfo.nStates, ruleName, nStates);
+      return 1;
+    }
+    unsigned long start = millis();
+    snapshot.restore(*life);
+    firstGeneration = snapshotInfo.generation;
+    rng.setState(snapshotInfo.randomState);
+    printf("restored generation %lld in %lu ms\n", (long long)firstGeneration, millis() - start);
+    free(text);
+  } else if (macrocell) {
+    MacrocellReader reader;
+    if (!reader.parse(text, text + textLength, nStates)) {
+      fprintf(stderr, "can't read %s\n", pattern);
+      return 1;
+    }
+    unsigned long start = millis();
+    if (hashLife) {
+      reader.load(*hashLife);
+    } else {
+      reader.load(*life, 0, 0);
+    }
+    printf("loaded %d nodes at level %d in %lu ms\n", reader.getNodeCount(), reader.getLevel(), millis() - start);
+    free(text);
+  } else if (pattern) {
+    loadRLE(*life, 0, 0, text, text + textLength, nStates);
+    free(text);
+  } else {
+    life->clear();
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        if (rng.random(1000000) < density * 1000000) life->set(x, y, rng.random(1, nStates));
+      }
+    }
+  }
+
+  unsigned long start = millis();
+  if (hashLife) {
+    hashLife->advance(generations);
+  } else {
+    for (long g = 0; g < generations; g++) life->nextGeneration();
+  }
+  unsigned long elapsed = millis() - start;
+
+  long population = 0;
+  int xMin = INT_MAX, yMin = INT_MAX, xMax = INT_MIN, yMax = INT_MIN;
+  life->forEachLive([&](int x, int y, int) {
+    population++;
+    xMin = min(xMin, x);
+    xMax = max(xMax, x);
+    yMin = min(yMin, y);
+    yMax = max(yMax, y);
+  });
+  printf("engine %s rule %s generations %ld\n", engine, ruleName, generations);
+  if (firstGeneration) printf("generation %lld\n", (long long)(firstGeneration + generations));
+  printf("population %ld\n", population);
+  if (population) {
+    printf("bounding box (%d,%d)-(%d,%d) %dx%d\n", xMin, yMin, xMax, yMax, xMax - xMin + 1, yMax - yMin + 1);
+  }
+  printf("time %lu ms, %.1f generations/s\n", elapsed, elapsed ? generations * 1000.0 / elapsed : 0.0);
+
+  if (output) {
+    FILE* file = fopen(output, "w");
+    if (!file) {
+      perror(output);
+      return 1;
+    }
+    // Other engines are copied into a hash engine to be written
+    HashLife* tree = hashLife;
+    if (!tree) {
+      tree = new HashLife(nStates, rule);
+      life->forEachLive([tree](int x, int y, int value) {
+        tree->set(x, y, value);
+      });
+    }
+    bool ok = writeMacrocell(*tree, file, ruleName);
+    if (tree != hashLife) delete tree;
+    if (fclose(file) != 0 || !ok) {
+      perror(output);
+      return 1;
+    }
+  }
+
+  if (snapshotOutput) {
+    FILE* file = fopen(snapshotOutput, "wb");
+    if (!file) {
+      perror(snapshotOutput);
+      return 1;
+    }
+    SnapshotInfo info;
+    info.rule = -1;
+    for (int i = 0; i < nSnapshotRules; i++) {
+      if (!strcmp(ruleName, snapshotRules[i])) info.rule = i;
+    }
+    info.nStates = nStates;
+    info.generation = firstGeneration + generations;
+    info.randomState = rng.getState();
+    bool ok = snapshot.take(*life, info);
+    if (ok) ok = fwrite(snapshot.getData(), 1, snapshot.getBytes(), file) == snapshot.getBytes();
+    if (fclose(file) != 0 || !ok) {
+      perror(snapshotOutput);
+      return 1;
+    }
+  }
+  delete life;
+  delete gollyRule;
+  delete pool;
+  return 0;
+}
@@ -0,0 +1,268 @@
+// Compiles RLE and macrocell patterns into the packed rows of PackedPattern.h,
+// written to stdout as C++ for the matrix to keep in flash. Build with
+// "pio run -e patterns".
+//
+// PatternCompiler > src/PatternCatalog.h
+//   compiles the patterns in Patterns.h, with how they are shown
+// PatternCompiler pattern.rle|pattern.mc ...
+//   compiles the given files instead, running the rule in each header
+//   (B3/S23, 12345/45678/8 or 345/2/4, or the LifeCli names of those) with
+//   the default display settings.
+//   Macrocell patterns are moved so that their live cells start at (0, 0).
+//
+// Cells marked 'o' are packed as the all ones value, for loadPackedPattern to
+// give them random colours each time the pattern is shown. Under a rule with
+// no spare value for that, they are given their colours here instead, with the
+// random seed fixed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../Life.h"
+#include "../Macrocell.h"
+#include "../PackedPattern.h"
+#include "../Patterns.h"
+#include "../RLE.h"
+
+struct Compiled {
+  std::string id;
+  const char* name;
+  PatternRule rule;
+  int width;
+  int height;
+  int bits;
+  std::vector<int> rows;
+  bool randomColours;
+  PatternDisplay display;
+};
+
+// Identifier from a pattern's name, "Tanner's p46 gun" becomes tannersP46Gun
+static std::string identifier(const char* name) {
+  std::string id;
+  int words = 0;
+  for (const char* c = name; *c;) {
+    if (!isalnum(*c)) {
+      c++;
+      continue;
+    }
+    for (int i = 0; isalnum(*c) || *c == '\''; c++) {
+      if (*c == '\'') continue;
+      id += words == 0 ? tolower(*c) : i == 0 ? toupper(*c) : *c;
+      i++;
+    }
+    words++;
+  }
+  if (id.empty() || isdigit(id[0])) id = "pattern" + id;
+  return id;
+}
+
+// Pack the live cells in the order forEachLive visits them, by row then x,
+// moved by (-xMin, -yMin)
+static void pack(Life& life, int bits, std::vector<int>& rows, int xMin = 0, int yMin = 0) {
+  int cellsPerWord = 64 / bits;
+  int y = INT_MIN;
+  int wordX = 0;
+  size_t word = 0;
+  life.forEachLive([&](int x, int cellY, int value) {
+    x -= xMin;
+    cellY -= yMin;
+    if (cellY != y) {
+      rows.push_back(-(cellY + 1));
+      y = cellY;
+    } else if (x - wordX < cellsPerWord) {
+      int shift = bits * (x - wordX);
+      rows[word + (shift >> 5)] |= (uint32_t)value << (shift & 31);
+      return;
+    }
+    wordX = x;
+    rows.push_back(x);
+    word = rows.size();
+    rows.push_back(value);
+    rows.push_back(0);
+  });
+}
+
+static bool compile(Compiled& out, const char* name, const char* rle, const char* end, PatternRule rule,
+                    const PatternDisplay& display) {
+  int nStates;
+  TreeRule* treeRule = patternTreeRule(rule, nStates);
+  InfiniteLife life(nStates, treeRule, 10000, 1 << 24);
+  randomSeed(1);
+  RLEHeader header;
+  int bits = InfiniteLife::bitsPerCell(nStates);
+  int marker = (1 << bits) - 1;
+  if (marker < nStates) marker = 0;
+  loadRLE(life, 0, 0, rle, end, nStates, &header, marker);
+  if (life.getCulledCells()) {
+    fprintf(stderr, "%s is too big\n", name);
+    return false;
+  }
+  out.id = identifier(name);
+  out.name = name;
+  out.rule = rule;
+  out.width = header.width;
+  out.height = header.height;
+  out.bits = bits;
+  out.display = display;
+  out.randomColours = false;
+  life.forEachLive([&](int, int, int value) {
+    if (marker && value == marker) out.randomColours = true;
+  });
+  pack(life, out.bits, out.rows);
+  return true;
+}
+
+static bool compileMacrocell(Compiled& out, const char* name, const char* text, const char* end, PatternRule rule) {
+  int nStates;
+  TreeRule* treeRule = patternTreeRule(rule, nStates);
+  MacrocellReader reader;
+  if (!reader.parse(text, end, nStates) || reader.getLevel() > 14) {
+    fprintf(stderr, "%s is not a macrocell pattern the matrix can hold\n", name);
+    return false;
+  }
+  InfiniteLife life(nStates, treeRule, 10000, 1 << 24);
+  int half = 1 << (reader.getLevel() - 1);
+  reader.load(life, half, half);
+  if (life.getCulledCells()) {
+    fprintf(stderr, "%s is too big\n", name);
+    return false;
+  }
+  int xMin = INT_MAX, yMin = INT_MAX, xMax = INT_MIN, yMax = INT_MIN;
+  life.forEachLive([&](int x, int y, int) {
+    xMin = min(xMin, x);
+    xMax = max(xMax, x);
+    yMin = min(yMin, y);
+    yMax = max(yMax, y);
+  });
+  out.id = identifier(name);
+  out.name = name;
+  out.rule = rule;
+  out.width = xMax >= xMin ? xMax - xMin + 1 : 0;
+  out.height = yMax >= yMin ? yMax - yMin + 1 : 0;
+  out.bits = InfiniteLife::bitsPerCell(nStates);
+  out.display = PatternDisplay();
+  out.randomColours = false;
+  pack(life, out.bits, out.rows, xMin, yMin);
+  return true;
+}
+
+static bool ruleFromHeader(const char* rule, PatternRule& out) {
+  if (!*rule || !strcmp(rule, "B3/S23") || !strcmp(rule, "b3/s23") || !strcmp(rule, "23/3") ||
+      !strcmp(rule, "niemiec")) {
+    out = PatternNiemiec;
+  } else if (!strcmp(rule, "12345/45678/8") || !strcmp(rule, "generations")) {
+    out = PatternGenerations;
+  } else if (!strcmp(rule, "345/2/4") || !strcmp(rule, "generations1")) {
+    out = PatternGenerations1;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool compileFile(Compiled& out, const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char* text = (char*)malloc(length > 0 ? length : 1);
+  length = length > 0 ? fread(text, 1, length, file) : 0;
+  fclose(file);
+  size_t pathLength = strlen(path);
+  bool macrocell = pathLength > 3 && !strcmp(path + pathLength - 3, ".mc");
+  RLEHeader header;
+  if (macrocell) {
+    MacrocellHeader macrocellHeader;
+    parseMacrocellHeader(text, text + length, macrocellHeader);
+    strcpy(header.rule, macrocellHeader.rule);
+  } else {
+    parseRLEHeader(text, text + length, &header);
+  }
+  PatternRule rule;
+  bool ok = ruleFromHeader(header.rule, rule);
+  if (!ok) {
+    fprintf(stderr, "%s: rule %s is not one the matrix runs\n", path, header.rule);
+  } else {
+    const char* name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    name = strndup(name, strcspn(name, "."));
+    ok = macrocell ? compileMacrocell(out, name, text, text + length, rule)
+                   : compile(out, name, text, text + length, rule, PatternDisplay());
+  }
+  free(text);
+  return ok;
+}
+
+static const char* const ruleNames[] = { "PatternNiemiec", "PatternGenerations", "PatternGenerations1" };
+
+static void write(const std::vector<Compiled>& patterns) {
+  printf("#ifndef PatternCatalog_h\n#define PatternCatalog_h\n\n");
+  printf("// Generated by host/PatternCompiler.cpp, do not edit\n\n");
+  printf("#include \"PackedPattern.h\"\n");
+  for (const Compiled& p : patterns) {
+    printf("\n// %s, %d x %d\n", p.name, p.width, p.height);
+    // A line for each row, with the words in hex
+    printf("const int %sRows[] = {", p.id.c_str());
+    int column = 0;
+    for (size_t i = 0; i < p.rows.size(); i++) {
+      if (p.rows[i] < 0) {
+        column = printf("\n  %d,", p.rows[i]);
+        continue;
+      }
+      if (column > 70) column = printf("\n   ");
+      column += printf(" %d,", p.rows[i]);
+      for (int half = 1; half <= 2; half++) {
+        column += printf(p.rows[i + half] < 0 ? " (int)0x%x," : " 0x%x,", p.rows[i + half]);
+      }
+      i += 2;
+    }
+    printf("\n};\n");
+    const PatternDisplay& d = p.display;
+    if (d.palette) {
+      printf("const uint32_t %sPalette[] = {", p.id.c_str());
+      for (int i = 0; i < d.nColors; i++) printf(" 0x%06x%s", d.palette[i], i + 1 < d.nColors ? "," : " ");
+      printf("};\n");
+    }
+    printf("const PackedPattern %sPacked = { \"%s\", %s, %d, %d, %d, %sRows, %d, %s,\n", p.id.c_str(), p.name,
+           ruleNames[p.rule], p.width, p.height, p.bits, p.id.c_str(), (int)p.rows.size(),
+           p.randomColours ? "true" : "false");
+    printf("  { %s%s, %d, %d, %d, %d, %d, %d, %d, %d } };\n", d.palette ? p.id.c_str() : "0", d.palette ? "Palette" : "",
+           d.nColors, d.left, d.top, d.speedX, d.speedY, d.speedDivisor, d.initialDelay, d.weight);
+  }
+  printf("\nconst PackedPattern* const patternCatalog[] = {\n");
+  for (const Compiled& p : patterns) printf("  &%sPacked,\n", p.id.c_str());
+  printf("};\nconst int nCatalogPatterns = sizeof(patternCatalog) / sizeof(patternCatalog[0]);\n\n#endif\n");
+}
+
+int main(int argc, char** argv) {
+  std::vector<Compiled> patterns;
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      patterns.emplace_back();
+      if (!compileFile(patterns.back(), argv[i])) return 1;
+    }
+  } else {
+    for (int i = 0; i < nPatterns; i++) {
+      const Pattern* pattern = allPatterns[i];
+      patterns.emplace_back();
+      Compiled& out = patterns.back();
+      if (!compile(out, pattern->name, pattern->rle, pattern->rle + strlen(pattern->rle), pattern->rule, pattern->display)) {
+        return 1;
+      }
+      // The patterns in Patterns.h have no header
+      out.width = pattern->width;
+      out.height = pattern->height;
+    }
+  }
+  size_t total = 0;
+  for (const Compiled& p : patterns) total += p.rows.size() * sizeof(int);
+  fprintf(stderr, "%d patterns, %zu bytes of rows\n", (int)patterns.size(), total);
+  write(patterns);
+  return 0;
+}